@@ -1,5 +1,6 @@
 #include "evaluator.hpp"
 #include "../Expression/evaluation_context.hpp"
+#include "../Expression/data_helper.hpp"
 
 namespace compiler::evaluate {
   namespace instruction_archive = instruction::output::archive_part;
@@ -13,6 +14,7 @@ namespace compiler::evaluate {
     std::vector<FunctionCast> function_casts;
     std::vector<Rule> rules;
     std::vector<RuleExplanation> rule_explanations;
+    std::vector<PackedNat> packed_nats;
     std::vector<expression::TypedValue> locals;
 
     expression::TypedValue make_variable_typed(expression::tree::Expression type, variable_explanation::Any explanation, expression::Stack& local_context) {
@@ -38,8 +40,11 @@ namespace compiler::evaluate {
     }
     expression::tree::Expression cast(expression::TypedValue input, expression::tree::Expression new_type, variable_explanation::Any cast_var_explanation, expression::Stack& local_context) {
       if(expression_context.reduce(input.type) == expression_context.reduce(new_type)) return std::move(input.value);
+      return make_cast(std::move(input), std::move(new_type), std::move(cast_var_explanation), local_context);
+    }
+    expression::tree::Expression make_cast(expression::TypedValue input, expression::tree::Expression new_type, variable_explanation::Any cast_var_explanation, expression::Stack& local_context) {
       auto cast_var = make_variable(new_type, cast_var_explanation, local_context);
-      auto var = expression::unfold(cast_var).head.get_external().external_index;
+      auto var = expression::spine_head(cast_var).get_external().external_index;
       casts.push_back({
         .stack = local_context,
         .variable = var,
@@ -63,27 +68,21 @@ namespace compiler::evaluate {
           auto lhs = evaluate(apply.lhs, local_context);
           auto rhs = evaluate(apply.rhs, local_context);
           auto [lhs_value, lhs_domain, lhs_codomain, rhs_value] = [&]() -> std::tuple<expression::tree::Expression, expression::tree::Expression, expression::tree::Expression, expression::tree::Expression> {
-            auto lhs_type = expression_context.reduce(lhs.first.type);
-            if(auto* lhs_apply = lhs_type.get_if_apply()) {
-              if(auto* inner_apply = lhs_apply->lhs.get_if_apply()) {
-                if(auto* lhs_ext = inner_apply->lhs.get_if_external()) {
-                  if(lhs_ext->external_index == expression_context.primitives.arrow) {
-                    auto domain = inner_apply->rhs;
-                    return std::make_tuple(
-                      std::move(lhs.first.value),
-                      std::move(inner_apply->rhs),
-                      std::move(lhs_apply->rhs),
-                      cast(
-                        std::move(rhs.first),
-                        std::move(domain),
-                        variable_explanation::ApplyRHSCast{local_context.depth(), apply.index()},
-                        local_context
-                      )
-                    );
-                  }
-                }
-              }
+            if(auto function_type = expression_context.get_domain_and_codomain(lhs.first.type)) {
+              auto domain = expression_context.reduce(std::move(function_type->domain));
+              return std::make_tuple(
+                std::move(lhs.first.value),
+                domain,
+                std::move(function_type->codomain),
+                cast(
+                  std::move(rhs.first),
+                  domain,
+                  variable_explanation::ApplyRHSCast{local_context.depth(), apply.index()},
+                  local_context
+                )
+              );
             }
+            auto lhs_type = expression_context.reduce(lhs.first.type);
             auto domain = make_variable(
               expression::tree::External{expression_context.primitives.type},
               variable_explanation::ApplyCodomain{local_context.depth(), apply.index()},
@@ -104,8 +103,8 @@ namespace compiler::evaluate {
             );
             auto func = make_variable(expected_function_type, variable_explanation::ApplyLHSCast{local_context.depth(), apply.index()}, local_context);
             auto arg = make_variable(domain, variable_explanation::ApplyRHSCast{local_context.depth(), apply.index()}, local_context);
-            auto func_var = expression::unfold(func).head.get_external().external_index;
-            auto arg_var = expression::unfold(arg).head.get_external().external_index;
+            auto func_var = expression::spine_head(func).get_external().external_index;
+            auto arg_var = expression::spine_head(arg).get_external().external_index;
             function_casts.push_back({
               .stack = local_context,
               .function_variable = func_var,
@@ -145,8 +144,6 @@ namespace compiler::evaluate {
           switch(primitive.primitive) {
             case instruction::Primitive::type: return {expression_context.get_external(expression_context.primitives.type), forward_locator::PrimitiveExpression{}};
             case instruction::Primitive::arrow: return {expression_context.get_external(expression_context.primitives.arrow), forward_locator::PrimitiveExpression{}};
-            case instruction::Primitive::push_vec: return {expression_context.get_external(expression_context.primitives.push_vec), forward_locator::PrimitiveExpression{}};
-            case instruction::Primitive::empty_vec: return {expression_context.get_external(expression_context.primitives.empty_vec), forward_locator::PrimitiveExpression{}};
           }
           std::terminate();
         },
@@ -170,6 +167,73 @@ namespace compiler::evaluate {
               std::move(type_family_type.second)
             }
           };
+        },
+        [&](instruction_archive::VectorLiteral const& vector_literal) -> ExpressionResult {
+          auto const& vector = *expression_context.primitives.vector;
+          auto vector_of = [&](expression::tree::Expression type) -> expression::tree::Expression {
+            return expression::tree::Apply{expression::tree::External{vector.get_type_family_axiom()}, std::move(type)};
+          };
+          auto type_raw = evaluate(vector_literal.type, local_context);
+          auto element_type = cast(
+            std::move(type_raw.first),
+            expression::tree::External{expression_context.primitives.type},
+            variable_explanation::VectorTypeCast{local_context.depth(), vector_literal.index()},
+            local_context
+          );
+          std::vector<expression::TypedValue> elements;
+          std::vector<expression::tree::Expression> element_types; //reduced
+          std::vector<forward_locator::Expression> element_forwards;
+          for(auto const& element : vector_literal.elements) {
+            auto element_eval = evaluate(element, local_context);
+            element_types.push_back(expression_context.reduce(element_eval.first.type));
+            elements.push_back(std::move(element_eval.first));
+            element_forwards.push_back(std::move(element_eval.second));
+          }
+          auto value = [&]() -> expression::tree::Expression {
+            if(!elements.empty() && std::adjacent_find(element_types.begin(), element_types.end(), std::not_equal_to<>{}) == element_types.end()) {
+              //All elements agree on their type, so check it once for the whole vector.
+              std::vector<expression::tree::Expression> values;
+              values.reserve(elements.size());
+              for(auto& element : elements) {
+                values.push_back(std::move(element.value));
+              }
+              return cast(
+                {
+                  .value = vector(element_types.front(), std::move(values)),
+                  .type = vector_of(element_types.front())
+                },
+                vector_of(element_type),
+                variable_explanation::VectorCast{local_context.depth(), vector_literal.index()},
+                local_context
+              );
+            }
+            auto reduced_element_type = expression_context.reduce(element_type);
+            std::vector<expression::tree::Expression> values;
+            values.reserve(elements.size());
+            for(std::size_t i = 0; i < elements.size(); ++i) {
+              if(element_types[i] == reduced_element_type) {
+                values.push_back(std::move(elements[i].value));
+              } else {
+                values.push_back(make_cast(
+                  std::move(elements[i]),
+                  element_type,
+                  variable_explanation::VectorElementCast{local_context.depth(), vector_literal.elements[i].index()},
+                  local_context
+                ));
+              }
+            }
+            return vector(element_type, std::move(values));
+          }();
+          return {
+            expression::TypedValue{
+              .value = std::move(value),
+              .type = vector_of(element_type)
+            },
+            forward_locator::VectorLiteral{
+              .type = std::move(type_raw.second),
+              .elements = std::move(element_forwards)
+            }
+          };
         }
       });
     }
@@ -261,6 +325,19 @@ namespace compiler::evaluate {
             };
           }
         },
+        [&](instruction_archive::PackedNat const& packed_nat) -> forward_locator::Command {
+          auto zero = evaluate(packed_nat.zero, local_context);
+          auto succ = evaluate(packed_nat.succ, local_context);
+          packed_nats.push_back({
+            .zero = std::move(zero.first),
+            .succ = std::move(succ.first),
+            .index = packed_nat.index()
+          });
+          return forward_locator::PackedNat{
+            .zero = std::move(zero.second),
+            .succ = std::move(succ.second)
+          };
+        },
         [&](instruction_archive::ForAll const& for_all) -> forward_locator::Command {
           auto local_size = locals.size();
           auto local_type_raw = evaluate(for_all.type, local_context);
@@ -306,6 +383,7 @@ namespace compiler::evaluate {
       .function_casts = std::move(detail.function_casts),
       .rules = std::move(detail.rules),
       .rule_explanations = std::move(detail.rule_explanations),
+      .packed_nats = std::move(detail.packed_nats),
       .result = std::move(result.first),
       .forward_locator = archive(forward_locator::ProgramRoot{
         .commands = std::move(command_forwards),
@@ -345,40 +423,34 @@ namespace compiler::evaluate {
             std::uint64_t count = 0;
             for(auto const& arg : segment.args) {
               auto val = evaluate_pattern(arg);
-              head.type = expression_context.reduce(std::move(head.type));
-              if(auto* lhs_apply = head.type.get_if_apply()) {
-                if(auto* inner_apply = lhs_apply->lhs.get_if_apply()) {
-                  if(auto* lhs_ext = inner_apply->lhs.get_if_external()) {
-                    if(lhs_ext->external_index == expression_context.primitives.arrow) {
-                      val.type = expression_context.reduce(std::move(val.type));
-                      if(val.type != inner_apply->rhs) {
-                        auto cast_var = expression_context.create_variable({
-                          .is_axiom = false,
-                          .type = inner_apply->rhs
-                        });
-                        variables.insert(std::make_pair(cast_var, pattern_variable_explanation::ApplyCast{ count, segment.index() }));
-                        casts.push_back({
-                          .stack = expression::Stack::empty(expression_context),
-                          .variable = cast_var,
-                          .source_type = val.type,
-                          .source = val.value,
-                          .target_type = inner_apply->rhs
-                        });
-                        head = expression::TypedValue{
-                          .value = expression::tree::Apply{std::move(head.value), expression::tree::External{cast_var}},
-                          .type = expression::tree::Apply{std::move(lhs_apply->rhs), expression::tree::External{cast_var}}
-                        };
-                      } else {
-                        head = expression::TypedValue{
-                          .value = expression::tree::Apply{std::move(head.value), val.value},
-                          .type = expression::tree::Apply{std::move(lhs_apply->rhs), val.value}
-                        };
-                      }
-                      ++count;
-                      continue;
-                    }
-                  }
+              if(auto function_type = expression_context.get_domain_and_codomain(std::move(head.type))) {
+                auto domain = expression_context.reduce(std::move(function_type->domain));
+                val.type = expression_context.reduce(std::move(val.type));
+                if(val.type != domain) {
+                  auto cast_var = expression_context.create_variable({
+                    .is_axiom = false,
+                    .type = domain
+                  });
+                  variables.insert(std::make_pair(cast_var, pattern_variable_explanation::ApplyCast{ count, segment.index() }));
+                  casts.push_back({
+                    .stack = expression::Stack::empty(expression_context),
+                    .variable = cast_var,
+                    .source_type = val.type,
+                    .source = val.value,
+                    .target_type = std::move(domain)
+                  });
+                  head = expression::TypedValue{
+                    .value = expression::tree::Apply{std::move(head.value), expression::tree::External{cast_var}},
+                    .type = expression::tree::Apply{std::move(function_type->codomain), expression::tree::External{cast_var}}
+                  };
+                } else {
+                  head = expression::TypedValue{
+                    .value = expression::tree::Apply{std::move(head.value), val.value},
+                    .type = expression::tree::Apply{std::move(function_type->codomain), val.value}
+                  };
                 }
+                ++count;
+                continue;
               }
               std::terminate(); //o no panic
             }
@@ -37,6 +37,11 @@ namespace compiler::evaluate {
   struct RuleExplanation {
     instruction::archive_index::Rule index;
   };
+  struct PackedNat { //checked and bound once solving is done
+    expression::TypedValue zero;
+    expression::TypedValue succ;
+    instruction::archive_index::PackedNat index;
+  };
   namespace variable_explanation {
     namespace archive_index = instruction::archive_index;
     struct ApplyRHSCast {
@@ -95,12 +100,24 @@ namespace compiler::evaluate {
       std::uint64_t depth;
       archive_index::ForAll index;
     };
+    struct VectorTypeCast {
+      std::uint64_t depth;
+      archive_index::VectorLiteral index;
+    };
+    struct VectorCast { //casts a whole vector literal whose elements share a type
+      std::uint64_t depth;
+      archive_index::VectorLiteral index;
+    };
+    struct VectorElementCast {
+      std::uint64_t depth;
+      archive_index::Expression index;
+    };
     struct VarType {
       std::uint64_t depth;
       std::uint64_t base_variable;
       archive_index::PolymorphicKind index;
     };
-    using Any = std::variant<ApplyRHSCast, ApplyDomain, ApplyCodomain, ApplyLHSCast, ExplicitHole, Declaration, Axiom, TypeFamilyCast, HoleTypeCast, DeclareTypeCast, AxiomTypeCast, LetCast, LetTypeCast, ForAllTypeCast, VarType>;
+    using Any = std::variant<ApplyRHSCast, ApplyDomain, ApplyCodomain, ApplyLHSCast, ExplicitHole, Declaration, Axiom, TypeFamilyCast, HoleTypeCast, DeclareTypeCast, AxiomTypeCast, LetCast, LetTypeCast, ForAllTypeCast, VectorTypeCast, VectorCast, VectorElementCast, VarType>;
     inline bool is_axiom(Any const& any) { return std::holds_alternative<Axiom>(any); }
     inline bool is_declaration(Any const& any) { return std::holds_alternative<Declaration>(any); }
     inline bool is_variable(Any const& any) { return std::holds_alternative<ApplyDomain>(any) || std::holds_alternative<ApplyCodomain>(any) || std::holds_alternative<ExplicitHole>(any); }
@@ -126,6 +143,7 @@ namespace compiler::evaluate {
     std::vector<FunctionCast> function_casts;
     std::vector<Rule> rules;
     std::vector<RuleExplanation> rule_explanations;
+    std::vector<PackedNat> packed_nats;
     expression::TypedValue result;
     compiler::instruction::forward_locator::archive_root::Program forward_locator;
   };
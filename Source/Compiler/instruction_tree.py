@@ -11,6 +11,10 @@ shape = CompoundShape({
         "PrimitiveExpression": [],
         "TypeFamilyOver": [
             ("type", "Expression")
+        ],
+        "VectorLiteral": [
+            ("type", "Expression"),
+            ("elements", vector("Expression"))
         ]
     },
     "Command": {
@@ -34,6 +38,10 @@ shape = CompoundShape({
         "ForAll": [
             ("type", "Expression"),
             ("commands", vector("Command"))
+        ],
+        "PackedNat": [
+            ("zero", "Expression"),
+            ("succ", "Expression")
         ]
     },
     "Program": {
@@ -55,7 +63,8 @@ output = shape.generate_instance(namespace = "compiler::instruction::output", da
         "PrimitiveExpression": [
             ("primitive", "Primitive")
         ],
-        "TypeFamilyOver": []
+        "TypeFamilyOver": [],
+        "VectorLiteral": []
     },
     "Command": {
         "DeclareHole": [],
@@ -63,7 +72,8 @@ output = shape.generate_instance(namespace = "compiler::instruction::output", da
         "Rule": [],
         "Axiom": [],
         "Let": [],
-        "ForAll": []
+        "ForAll": [],
+        "PackedNat": []
     },
     "Program": {
         "ProgramRoot": []
@@ -75,7 +85,8 @@ locator = shape.generate_instance(namespace = "compiler::instruction::locator",
         "Local": [("source", "Explanation")],
         "Embed": [("source", "Explanation")],
         "PrimitiveExpression": [("source", "Explanation")],
-        "TypeFamilyOver": [("source", "Explanation")]
+        "TypeFamilyOver": [("source", "Explanation")],
+        "VectorLiteral": [("source", "Explanation")]
     },
     "Command": {
         "DeclareHole": [("source", "Explanation")],
@@ -83,7 +94,8 @@ locator = shape.generate_instance(namespace = "compiler::instruction::locator",
         "Rule": [("source", "Explanation")],
         "Axiom": [("source", "Explanation")],
         "Let": [("source", "Explanation")],
-        "ForAll": [("source", "Explanation")]
+        "ForAll": [("source", "Explanation")],
+        "PackedNat": [("source", "Explanation")]
     },
     "Program": {
         "ProgramRoot": [("source", "Explanation")]
@@ -95,7 +107,8 @@ forward_locator = shape.generate_instance(namespace = "compiler::instruction::fo
         "Local": [],
         "Embed": [],
         "PrimitiveExpression": [],
-        "TypeFamilyOver": []
+        "TypeFamilyOver": [],
+        "VectorLiteral": []
     },
     "Command": {
         "DeclareHole": [("result", "expression::TypedValue")],
@@ -103,7 +116,8 @@ forward_locator = shape.generate_instance(namespace = "compiler::instruction::fo
         "Rule": [],
         "Axiom": [("result", "expression::TypedValue")],
         "Let": [("result", "expression::TypedValue")],
-        "ForAll": []
+        "ForAll": [],
+        "PackedNat": []
     },
     "Program": {
         "ProgramRoot": []
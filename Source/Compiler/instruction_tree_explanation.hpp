@@ -5,7 +5,7 @@
 
 namespace compiler::instruction {
   enum class ExplanationKind {
-    root, direct_apply, pattern_apply, pattern_id, pattern_embed, pattern_hole, lambda_type, lambda_type_local, lambda_type_hole_type, lambda_type_hole, lambda_type_hole_local, lambda_codomain_hole_type, lambda_codomain_hole, lambda_codomain_hole_local, lambda_type_arrow, lambda_type_arrow_apply, lambda_declaration, lambda_declaration_local, lambda_for_all_arg, lambda_for_all, lambda_pat_apply, lambda_rule, id_local, id_embed, hole_type_type, hole_type, hole_type_local, hole, hole_local, arrow_domain, arrow_domain_local, arrow_codomain_type, arrow_codomain_type_family, arrow_codomain, arrow_for_all_arg, arrow_for_all, arrow_pattern_apply, arrow_rule, arrow_arrow, arrow_arrow_apply, arrow_arrow_complete, declare, rule_pattern_type_hole_type, rule_pattern_type_hole, rule_pattern_type_local, rule_pattern_arg, rule_pattern_for_all, rule, axiom, let, literal_embed, vector_type_type, vector_type, vector_type_local, vector_element, vector_element_local, vector_empty, vector_empty_typed, vector_push, vector_push_typed, vector_push_vector, vector_push_element
+    root, direct_apply, pattern_apply, pattern_id, pattern_embed, pattern_hole, lambda_type, lambda_type_local, lambda_type_hole_type, lambda_type_hole, lambda_type_hole_local, lambda_codomain_hole_type, lambda_codomain_hole, lambda_codomain_hole_local, lambda_type_arrow, lambda_type_arrow_apply, lambda_declaration, lambda_declaration_local, lambda_for_all_arg, lambda_for_all, lambda_pat_apply, lambda_rule, id_local, id_embed, hole_type_type, hole_type, hole_type_local, hole, hole_local, arrow_domain, arrow_domain_local, arrow_codomain_type, arrow_codomain_type_family, arrow_codomain, arrow_for_all_arg, arrow_for_all, arrow_pattern_apply, arrow_rule, arrow_arrow, arrow_arrow_apply, arrow_arrow_complete, declare, rule_pattern_type_hole_type, rule_pattern_type_hole, rule_pattern_type_local, rule_pattern_arg, rule_pattern_for_all, rule, axiom, let, packed_nat, literal_embed, vector_type_type, vector_type, vector_type_local, vector_literal
   };
   struct Explanation {
     ExplanationKind kind;
@@ -15,7 +15,7 @@ namespace compiler::instruction {
     return lhs.kind == rhs.kind && lhs.index == rhs.index;
   }
   enum class Primitive {
-    type, arrow, empty_vec, push_vec
+    type, arrow
   };
   inline std::ostream& operator<<(std::ostream& o, Primitive primitive) {
     switch(primitive) {
@@ -235,32 +235,15 @@ namespace compiler::instruction {
             .type = type({ExplanationKind::vector_type_type, vector_literal.index()}),
             .source = {ExplanationKind::vector_type, vector_literal.index()}
           }, {ExplanationKind::vector_type_local, vector_literal.index()});
-          located_output::Expression ret = located_output::Apply{
-            .lhs = located_output::PrimitiveExpression{Primitive::empty_vec, {ExplanationKind::vector_empty, vector_literal.index()}},
-            .rhs = vector_type,
-            .source = {ExplanationKind::vector_empty_typed, vector_literal.index()}
-          };
+          std::vector<located_output::Expression> elements;
           for(auto const& element : vector_literal.elements) {
-            auto element_value = result_of(located_output::Let{
-              .value = compile(element),
-              .type = vector_type,
-              .source = {ExplanationKind::vector_element, element.index()}
-            }, {ExplanationKind::vector_element_local, element.index()});
-            ret = located_output::Apply{
-              .lhs = located_output::Apply{
-                .lhs = located_output::Apply{
-                  .lhs = located_output::PrimitiveExpression{Primitive::push_vec, {ExplanationKind::vector_push, element.index()}},
-                  .rhs = vector_type,
-                  .source = {ExplanationKind::vector_push_typed, element.index()}
-                },
-                .rhs = std::move(ret),
-                .source = {ExplanationKind::vector_push_vector, element.index()}
-              },
-              .rhs = std::move(element_value),
-              .source = {ExplanationKind::vector_push_element, element.index()}
-            };
+            elements.push_back(compile(element));
           }
-          return ret;
+          return located_output::VectorLiteral{
+            .type = std::move(vector_type),
+            .elements = std::move(elements),
+            .source = {ExplanationKind::vector_literal, vector_literal.index()}
+          };
         }
       });
     }
@@ -316,6 +299,13 @@ namespace compiler::instruction {
             } (),
             .source = {ExplanationKind::let, let.index()}
           });
+        },
+        [&](resolved_archive::PackedNat const& packed_nat) {
+          commands.push_back(located_output::PackedNat{
+            .zero = compile(packed_nat.zero),
+            .succ = compile(packed_nat.succ),
+            .source = {ExplanationKind::packed_nat, packed_nat.index()}
+          });
         }
       });
     }
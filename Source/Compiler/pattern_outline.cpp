@@ -31,7 +31,12 @@ namespace compiler::pattern {
           }
           return CapturePoint{};
         }
-        if(unfolded.head.get_if_data()) return std::nullopt; //can't define data heads
+        if(auto* data = unfolded.head.get_if_data()) {
+          if(unfolded.args.empty()) {
+            if(auto peeled = data->data.peel()) return convert(*peeled, spine); //packed data matches as the application it stands for
+          }
+          return std::nullopt; //can't define data heads
+        }
         auto head_index = unfolded.head.get_external().external_index;
         if(indeterminates.contains(head_index)) return std::nullopt; //cannot match indeterminates ever.
         if(spine && expression_context.external_info[head_index].is_axiom) return std::nullopt; //can't have a rule with axiom head.
@@ -0,0 +1,76 @@
+#ifndef EXPRESSION_BUDGET_HPP
+#define EXPRESSION_BUDGET_HPP
+
+#include "../Utility/node_pool.hpp"
+#include <atomic>
+#include <cstdint>
+#include <limits>
+
+namespace expression {
+  struct BudgetExceeded {
+    enum class Reason {
+      steps, //too many rule applications or solver steps
+      nodes, //too many expression nodes allocated
+      cancelled //cancel() was called
+    };
+    Reason reason;
+    std::uint64_t steps; //used when the budget ran out
+    std::uint64_t nodes;
+  };
+  /*
+    Bounds the work done by a reduction or compilation. A step is charged for
+    each rule applied and each equation the solver examines; nodes count the
+    expression nodes allocated since the budget was created, so a budget
+    should be made for each request. Once the budget is exhausted, every
+    further charge throws BudgetExceeded.
+
+    cancel() may be called from another thread; it is noticed at the next step.
+  */
+  class Budget {
+  public:
+    struct Limits {
+      std::uint64_t steps = std::numeric_limits<std::uint64_t>::max();
+      std::uint64_t nodes = std::numeric_limits<std::uint64_t>::max();
+    };
+  private:
+    Limits limits;
+    std::uint64_t steps = 0;
+    std::uint64_t node_baseline = mdb::node_pool.allocation_count;
+    std::atomic<bool> cancelled = false;
+  public:
+    Budget() = default;
+    explicit Budget(Limits limits):limits(limits) {}
+    void cancel() { cancelled.store(true, std::memory_order_relaxed); }
+    std::uint64_t steps_used() const { return steps; }
+    std::uint64_t nodes_used() const { return mdb::node_pool.allocation_count - node_baseline; }
+    void charge_step() {
+      ++steps;
+      if(cancelled.load(std::memory_order_relaxed)) exceeded(BudgetExceeded::Reason::cancelled);
+      if(steps > limits.steps) exceeded(BudgetExceeded::Reason::steps);
+      if(nodes_used() > limits.nodes) exceeded(BudgetExceeded::Reason::nodes);
+    }
+  private:
+    [[noreturn]] void exceeded(BudgetExceeded::Reason reason) const {
+      throw BudgetExceeded{
+        .reason = reason,
+        .steps = steps,
+        .nodes = nodes_used()
+      };
+    }
+  };
+  /*
+    Installs a budget in the slot a computation reads it from, restoring
+    the previous one on exit.
+  */
+  class BudgetScope {
+    Budget*& slot;
+    Budget* prior;
+  public:
+    BudgetScope(Budget*& slot, Budget* budget):slot(slot),prior(slot) { slot = budget; }
+    BudgetScope(BudgetScope const&) = delete;
+    BudgetScope& operator=(BudgetScope const&) = delete;
+    ~BudgetScope() { slot = prior; }
+  };
+}
+
+#endif
@@ -16,6 +16,12 @@ namespace expression::data {
       return *get_type_vector()[index];
     }
   }
+  std::optional<tree::Expression> DataType::peel(Buffer const&) const {
+    return std::nullopt;
+  }
+  std::optional<tree::Expression> DataType::reduce_children(Buffer const&, mdb::function<tree::Expression(tree::Expression const&)>) const {
+    return std::nullopt;
+  }
   std::uint64_t register_type(std::unique_ptr<DataType> t) {
     auto ret = get_type_vector().size();
     get_type_vector().push_back(std::move(t));
@@ -58,9 +64,18 @@ namespace expression::data {
   void Data::visit_children(mdb::function<void(tree::Expression const&)> visitor) const {
     return get_data_type(type_index).visit_children(storage, std::move(visitor));
   }
+  tree::Expression Data::map_children(mdb::function<tree::Expression(tree::Expression const&)> mapper) const {
+    return get_data_type(type_index).map_children(storage, std::move(mapper));
+  }
   tree::Expression Data::type_of() const {
     return get_data_type(type_index).type_of(storage);
   }
+  std::optional<tree::Expression> Data::peel() const {
+    return get_data_type(type_index).peel(storage);
+  }
+  std::optional<tree::Expression> Data::reduce_children(mdb::function<tree::Expression(tree::Expression const&)> reducer) const {
+    return get_data_type(type_index).reduce_children(storage, std::move(reducer));
+  }
   std::ostream& operator<<(std::ostream& o, Data const& data) {
     get_data_type(data.type_index).debug_print(data.storage, o);
     return o;
@@ -24,7 +24,10 @@ namespace expression::data {
     virtual void pretty_print(Buffer const&, std::ostream&, mdb::function<void(tree::Expression)>) const = 0;
     virtual tree::Expression substitute(Buffer const&, std::vector<tree::Expression> const&) const = 0;
     virtual void visit_children(Buffer const&, mdb::function<void(tree::Expression const&)>) const = 0;
+    virtual tree::Expression map_children(Buffer const&, mdb::function<tree::Expression(tree::Expression const&)>) const = 0;
     virtual tree::Expression type_of(Buffer const&) const = 0;
+    virtual std::optional<tree::Expression> peel(Buffer const&) const; //the constructor application this value stands for, if any
+    virtual std::optional<tree::Expression> reduce_children(Buffer const&, mdb::function<tree::Expression(tree::Expression const&)>) const; //the value with its children reduced, if they might not be already
     virtual ~DataType() = default;
   };
   std::uint64_t register_type(std::unique_ptr<DataType>);
@@ -51,7 +54,10 @@ namespace expression::data {
     void pretty_print(std::ostream& o, mdb::function<void(tree::Expression)> format_data) const;
     tree::Expression substitute(std::vector<tree::Expression> const&) const;
     void visit_children(mdb::function<void(tree::Expression const&)>) const;
+    tree::Expression map_children(mdb::function<tree::Expression(tree::Expression const&)>) const;
     tree::Expression type_of() const;
+    std::optional<tree::Expression> peel() const;
+    std::optional<tree::Expression> reduce_children(mdb::function<tree::Expression(tree::Expression const&)>) const;
   };
 }
 
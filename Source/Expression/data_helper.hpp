@@ -10,8 +10,44 @@ namespace expression::data {
     struct Info {
       tree::Expression type;
       std::vector<tree::Expression> vec;
+      bool reduced = false; //if the type and the first reduced_size elements are known to be in normal form
+      std::uint64_t reduced_size = 0; //elements appended in place afterwards may not be
+    };
+    /*
+      Successive versions of a vector share one Info, each seeing only its
+      first `size` elements. Pushing onto a version that sees every element
+      appends in place, so building a vector one push at a time is amortized
+      linear; pushing onto an older version copies its prefix.
+    */
+    struct Store {
+      std::shared_ptr<Info> info;
+      std::uint64_t size;
+      bool operator==(Store const&) const = default;
+    };
+    /*
+      Read access to one version. Elements are looked up by index on each
+      access, so iteration stays valid if the shared buffer grows meanwhile.
+    */
+    class View {
+      Store store;
+    public:
+      View(Store store):store(std::move(store)) {}
+      class iterator {
+        Info const* info;
+        std::uint64_t index;
+      public:
+        iterator(Info const* info, std::uint64_t index):info(info), index(index) {}
+        tree::Expression const& operator*() const { return info->vec[index]; }
+        iterator& operator++() { ++index; return *this; }
+        bool operator==(iterator const&) const = default;
+      };
+      std::uint64_t size() const { return store.size; }
+      tree::Expression const& type() const { return store.info->type; }
+      tree::Expression const& operator[](std::uint64_t index) const { return store.info->vec[index]; }
+      iterator begin() const { return {store.info.get(), 0}; }
+      iterator end() const { return {store.info.get(), store.size}; }
+      Store const& get_store() const { return store; }
     };
-    using Store = std::shared_ptr<Info>;
     struct Impl : DataType {
       static_assert(sizeof(Store) <= 24 && alignof(Store) <= std::max(alignof(void*), alignof(std::uint64_t)));
       std::uint64_t type_index;
@@ -37,7 +73,7 @@ namespace expression::data {
       void pretty_print(Buffer const& me, std::ostream& o, mdb::function<void(tree::Expression)> sub_format) const override {
         bool first = true;
         o << "[";
-        for(auto const& expr : get(me)->vec) {
+        for(auto const& expr : View{get(me)}) {
           if(first) first = false;
           else o << ", ";
           sub_format(expr);
@@ -45,36 +81,74 @@ namespace expression::data {
         o << "]";
       }
       tree::Expression substitute(Buffer const& me, std::vector<tree::Expression> const& args) const override {
-        auto const& info = *get(me);
+        return map_children(me, [&](tree::Expression const& expr) {
+          return expression::substitute_into_replacement(args, expr);
+        });
+      }
+      tree::Expression map_children(Buffer const& me, mdb::function<tree::Expression(tree::Expression const&)> mapper) const override {
+        View view{get(me)};
         auto new_info = std::make_shared<Info>(Info{
-          .type = expression::substitute_into_replacement(args, info.type),
+          .type = mapper(view.type()),
           .vec = [&] {
             std::vector<tree::Expression> new_vec;
-            for(auto const& expr : info.vec) {
-              new_vec.push_back(expression::substitute_into_replacement(args, expr));
+            new_vec.reserve(view.size());
+            for(auto const& expr : view) {
+              new_vec.push_back(mapper(expr));
             }
             return new_vec;
           }()
         });
-        auto ret = tree::Expression{tree::Data{}};
-        auto& data = const_cast<tree::Data&>(ret.get_data());
-        data.data.type_index = type_index;
-        new (&data.data.storage) Store{std::move(new_info)};
-        return ret;
+        return make(type_index, std::move(new_info));
+      }
+      std::optional<tree::Expression> reduce_children(Buffer const& me, mdb::function<tree::Expression(tree::Expression const&)> reducer) const override {
+        auto const& store = get(me);
+        auto const& info = *store.info;
+        if(!info.reduced) {
+          auto ret = map_children(me, std::move(reducer));
+          auto& new_info = *get(ret.get_data().data.storage).info;
+          new_info.reduced = true;
+          new_info.reduced_size = new_info.vec.size();
+          return ret;
+        }
+        if(info.reduced_size >= store.size) return std::nullopt;
+        //Only the elements pushed since the last reduction need reducing.
+        std::vector<tree::Expression> new_vec;
+        new_vec.reserve(store.size);
+        new_vec.insert(new_vec.end(), info.vec.begin(), info.vec.begin() + info.reduced_size);
+        for(auto index = info.reduced_size; index < store.size; ++index) {
+          new_vec.push_back(reducer(info.vec[index]));
+        }
+        return make(type_index, std::make_shared<Info>(Info{
+          .type = info.type,
+          .vec = std::move(new_vec),
+          .reduced = true,
+          .reduced_size = store.size
+        }));
       }
       void visit_children(Buffer const& me, mdb::function<void(tree::Expression const&)> visitor) const override {
-        auto const& info = *get(me);
-        visitor(info.type);
-        for(auto const& expr : info.vec) {
+        View view{get(me)};
+        visitor(view.type());
+        for(auto const& expr : view) {
           visitor(expr);
         }
       }
       tree::Expression type_of(Buffer const& me) const override {
-        return tree::Apply{tree::External{type_family_axiom}, get(me)->type};
+        return tree::Apply{tree::External{type_family_axiom}, get(me).info->type};
       }
     };
     std::uint64_t type_index;
     std::uint64_t type_family_axiom;
+    static tree::Expression make(std::uint64_t type_index, Store store) {
+      auto ret = tree::Expression{tree::Data{}};
+      auto& d = const_cast<tree::Data&>(ret.get_data());
+      d.data.type_index = type_index;
+      new (&d.data.storage) Store{std::move(store)};
+      return ret;
+    }
+    static tree::Expression make(std::uint64_t type_index, std::shared_ptr<Info> info) {
+      auto size = info->vec.size();
+      return make(type_index, Store{std::move(info), size});
+    }
   public:
     Vector(std::uint64_t type_family_axiom):type_family_axiom(type_family_axiom) {
       auto impl = std::make_unique<Impl>();
@@ -84,18 +158,32 @@ namespace expression::data {
       ptr->type_index = type_index;
     }
     tree::Expression make_expression(tree::Expression type, std::vector<tree::Expression> data) const {
-      auto ret = tree::Expression{tree::Data{}};
-      auto& d = const_cast<tree::Data&>(ret.get_data());
-      d.data.type_index = type_index;
-      new (&d.data.storage) Store{std::make_shared<Info>(Info{
+      return make(type_index, std::make_shared<Info>(Info{
         .type = std::move(type),
         .vec = std::move(data)
-      })};
-      return ret;
+      }));
     }
     tree::Expression operator()(tree::Expression type, std::vector<tree::Expression> data) const {
       return make_expression(std::move(type), std::move(data));
     }
+    tree::Expression push(View const& view, tree::Expression value) const {
+      auto const& store = view.get_store();
+      if(store.info->vec.size() == store.size) {
+        store.info->vec.push_back(std::move(value));
+        return make(type_index, Store{store.info, store.size + 1});
+      } else {
+        std::vector<tree::Expression> data;
+        data.reserve(store.size + 1);
+        data.insert(data.end(), store.info->vec.begin(), store.info->vec.begin() + store.size);
+        data.push_back(std::move(value));
+        return make(type_index, std::make_shared<Info>(Info{
+          .type = store.info->type,
+          .vec = std::move(data),
+          .reduced = store.info->reduced,
+          .reduced_size = std::min(store.info->reduced_size, store.size)
+        }));
+      }
+    }
     std::uint64_t get_type_family_axiom() const {
       return type_family_axiom;
     }
@@ -139,6 +227,9 @@ namespace expression::data {
       void visit_children(Buffer const& me, mdb::function<void(tree::Expression const&)>) const override {
         //do nothing
       }
+      tree::Expression map_children(Buffer const& me, mdb::function<tree::Expression(tree::Expression const&)>) const override {
+        return substitute(me, {});
+      }
       tree::Expression type_of(Buffer const& me) const override {
         return tree::External{type_axiom};
       }
@@ -255,14 +346,14 @@ namespace expression::data {
     auto match(SmallScalar<T> const& type) {
       return DataMatch{
         type.get_type_index(),
-        [](auto& input) { return std::move((T&)input); }
+        [](auto& input) -> T const& { return (T const&)input; } //the data may be shared, so it must not be moved from
       };
     }
     inline auto match(Vector const& type) {
       return DataMatch{
         type.get_type_index(),
-        [](auto& input) -> std::vector<tree::Expression> const& {
-          return ((Vector::Store&)input)->vec;
+        [](auto& input) {
+          return Vector::View{(Vector::Store const&)input};
         }
       };
     }
@@ -284,8 +375,14 @@ namespace expression::data {
       auto pat = apply.get_pattern();
       return DataRule{
         .pattern = std::move(pat),
-        .replace = [apply = std::move(apply), callback = std::move(callback)](std::vector<tree::Expression> input) {
-          return apply.call(input, 0, callback);
+        .replace = [apply = std::move(apply), callback = std::move(callback)](std::vector<tree::Expression> input, Context& context) {
+          return apply.call(input, 0, [&]<class... Args>(Args&&... args) {
+            if constexpr(std::is_invocable_v<Callback&, Context&, Args&&...>) { //callbacks may ask for the context first
+              return callback(context, std::forward<Args>(args)...);
+            } else {
+              return callback(std::forward<Args>(args)...);
+            }
+          });
         }
       };
     }
@@ -360,7 +457,7 @@ namespace expression::data {
           });
           data_pattern::Pattern pat = data_pattern::Fixed{head};
           ((pat = data_pattern::Apply{std::move(pat), get_type_pattern<Args>()}) , ...);
-          auto replace = [*this, f = std::move(f)](std::vector<tree::Expression> input) -> tree::Expression {
+          auto replace = [*this, f = std::move(f)](std::vector<tree::Expression> input, Context&) -> tree::Expression {
             return [&]<std::size_t... index>(std::index_sequence<index...>) {
               return embed(
                 f(extract<Args>(input[index])...)
@@ -380,6 +477,118 @@ namespace expression::data {
     template<class... Kinds> RuleMaker(Context&, Kinds...) -> RuleMaker<Kinds...>;
 
   }
+  /*
+    Packs the numerals of a user-declared natural number type: succ^k zero is
+    stored as the count k for k > 0, while zero itself is left alone. Packed
+    numbers peel back into an application of succ wherever a pattern or the
+    solver needs to look inside them, so they behave like the unary terms
+    they stand for while taking constant space.
+  */
+  class PackedNat {
+    struct Impl : DataType {
+      std::uint64_t type_index = 0;
+      tree::Expression nat_type;
+      std::uint64_t zero;
+      std::uint64_t succ;
+      Impl(tree::Expression nat_type, std::uint64_t zero, std::uint64_t succ):nat_type(std::move(nat_type)), zero(zero), succ(succ) {}
+      std::uint64_t const& get(Buffer const& buf) const { return (std::uint64_t const&)buf; }
+      tree::Expression make(std::uint64_t count) const {
+        auto ret = tree::Expression{tree::Data{}};
+        auto& data = const_cast<tree::Data&>(ret.get_data());
+        data.data.type_index = type_index;
+        new (&data.data.storage) std::uint64_t{count};
+        return ret;
+      }
+      bool compare(Buffer const& lhs, Buffer const& rhs) const override {
+        return get(lhs) == get(rhs);
+      }
+      void copy(Buffer const& source, Buffer& target) const override {
+        new (&target) std::uint64_t{get(source)};
+      }
+      void move_destroy(Buffer& source, Buffer& target) const override {
+        new (&target) std::uint64_t{get(source)};
+      }
+      void destroy(Buffer& me) const override {
+        //trivially destructible
+      }
+      void debug_print(Buffer const& me, std::ostream& o) const override {
+        o << "<nat " << get(me) << ">";
+      }
+      void pretty_print(Buffer const& me, std::ostream& o, mdb::function<void(tree::Expression)>) const override {
+        debug_print(me, o);
+      }
+      tree::Expression substitute(Buffer const& me, std::vector<tree::Expression> const&) const override {
+        return make(get(me));
+      }
+      void visit_children(Buffer const& me, mdb::function<void(tree::Expression const&)>) const override {
+        //do nothing
+      }
+      tree::Expression map_children(Buffer const& me, mdb::function<tree::Expression(tree::Expression const&)>) const override {
+        return make(get(me));
+      }
+      tree::Expression type_of(Buffer const& me) const override {
+        return nat_type;
+      }
+      std::optional<tree::Expression> peel(Buffer const& me) const override {
+        auto count = get(me);
+        return tree::Apply{
+          tree::External{succ},
+          count == 1 ? tree::Expression{tree::External{zero}} : make(count - 1)
+        };
+      }
+    };
+    Impl* impl;
+  public:
+    using Type = std::uint64_t;
+    //Adds the data rules which pack succ zero and succ applied to a packed number.
+    PackedNat(Context& context, tree::Expression nat_type, std::uint64_t zero, std::uint64_t succ) {
+      auto new_impl = std::make_unique<Impl>(std::move(nat_type), zero, succ);
+      impl = new_impl.get();
+      impl->type_index = register_type(std::move(new_impl));
+      add_rules(context);
+    }
+    /*
+      Reuses the type for another zero and succ, adding their data rules. Types
+      are never unregistered, so a PackedNat whose rules were rolled back
+      should be rebound rather than a new one made.
+    */
+    void bind(Context& context, tree::Expression nat_type, std::uint64_t zero, std::uint64_t succ) {
+      impl->nat_type = std::move(nat_type);
+      impl->zero = zero;
+      impl->succ = succ;
+      add_rules(context);
+    }
+  private:
+    void add_rules(Context& context) {
+      auto* ptr = impl;
+      auto zero = impl->zero;
+      auto succ = impl->succ;
+      using namespace builder;
+      std::uint64_t const captures[] = {zero, succ}; //the type is reached through the type of zero
+      context.add_data_rule(pattern(fixed(succ), fixed(zero)) >> [ptr] {
+        return ptr->make(1);
+      }, captures);
+      context.add_data_rule(pattern(fixed(succ), DataMatch{ptr->type_index, [ptr](Buffer const& input) { return ptr->get(input); }}) >> [ptr](std::uint64_t count) {
+        return ptr->make(count + 1);
+      }, captures);
+    }
+  public:
+    tree::Expression make_expression(std::uint64_t count) const { //count must be positive
+      return impl->make(count);
+    }
+    tree::Expression operator()(std::uint64_t count) const {
+      return make_expression(count);
+    }
+    std::uint64_t get_type_index() const {
+      return impl->type_index;
+    }
+    std::uint64_t get_zero() const {
+      return impl->zero;
+    }
+    std::uint64_t get_succ() const {
+      return impl->succ;
+    }
+  };
 }
 
 #endif
@@ -1,4 +1,7 @@
 #include "evaluation_context.hpp"
+#include <algorithm>
+#include <unordered_set>
+#include <limits>
 
 namespace expression {
   Context::Context() {
@@ -178,24 +181,74 @@ namespace expression {
     primitives.arrow_codomain = 10;
   }
   namespace {
-    template<class Filter>
-    tree::Expression reduce_flat(Context& ctx, tree::Expression tree, Filter&& filter) {
-      struct TreeHasher {
-        std::hash<void const*> h;
-        auto operator()(tree::Expression const& expr) const noexcept {
-          return h(expr.data());
+    void note_rule_added(Context& ctx, std::uint64_t head) {
+      ctx.external_info[head].rule_epoch = ++ctx.rule_epoch;
+      ctx.rule_events.push_back(head);
+      if(ctx.external_info[head].is_axiom) {
+        ctx.reduction_cache.clear(); //axioms are never recorded as stuck heads
+      }
+    }
+    void fill_wildcard_counts(ExternalInfo::RuleInfo& rule_info, pattern::Pattern const& pattern) {
+      std::vector<bool> is_wildcard; //by argument, last first
+      pattern::Pattern const* head = &pattern;
+      while(auto* apply = head->get_if_apply()) {
+        is_wildcard.push_back(apply->rhs.holds_wildcard());
+        head = &apply->lhs;
+      }
+      rule_info.trailing_wildcards = std::find(is_wildcard.begin(), is_wildcard.end(), false) - is_wildcard.begin();
+      rule_info.leading_wildcards = std::find(is_wildcard.rbegin(), is_wildcard.rend(), false) - is_wildcard.rbegin();
+    }
+    void add_arities(ExternalInfo& info, ExternalInfo::RuleInfo const& rule_info) {
+      auto k = rule_info.arg_count;
+      if(info.arities.size() < k) info.arities.resize(k);
+      for(std::uint64_t n = 0; n < k; ++n) {
+        bool trivial = n <= rule_info.leading_wildcards;
+        (trivial ? info.arities[n].partial : info.arities[n].partial_if_matching) = true;
+        if(n + rule_info.trailing_wildcards >= k) {
+          (trivial ? info.arities[n].lambda_like : info.arities[n].lambda_like_if_matching) = true;
         }
-      };
+      }
+    }
+    void rebuild_rule_index(Context& ctx, std::uint64_t head) {
+      auto& info = ctx.external_info[head];
+      info.rule_index = RuleIndex{};
+      info.arities.clear();
+      for(auto const& rule_info : info.rules) {
+        add_arities(info, rule_info);
+        info.rule_index.add(ctx.rules[rule_info.index].pattern, {
+          .rank = RuleIndex::rank_of(false, rule_info.index),
+          .is_data = false,
+          .rule_index = rule_info.index,
+          .arg_count = rule_info.arg_count
+        });
+      }
+      for(auto const& rule_info : info.data_rules) {
+        info.rule_index.add(ctx.data_rules[rule_info.index].pattern, {
+          .rank = RuleIndex::rank_of(true, rule_info.index),
+          .is_data = true,
+          .rule_index = rule_info.index,
+          .arg_count = rule_info.arg_count
+        });
+      }
+    }
+    template<class Filter>
+    tree::Expression reduce_flat(Context& ctx, tree::Expression tree, Filter&& filter, ReductionCache& cache) {
       struct StackFrame {
+        tree::Expression source; //the expression this frame was pushed for; the cache key of its result.
+        tree::Expression spine; //the expression whose spine was unfolded into head and args.
+        bool changed; //if head or args differ from those of spine.
         tree::Expression head;
         std::uint64_t arg_count;
         std::uint64_t next_arg_to_reduce;
         std::size_t result_position;
+        ReductionCache::StuckHeads stuck_heads;
       };
-      std::unordered_map<tree::Expression, tree::Expression, TreeHasher> memoized_results;
       std::vector<tree::Expression> arg_stack;
       std::vector<StackFrame> stack;
-      auto push_stack_frame = [&](std::size_t result_position) {
+      std::vector<tree::Expression const*> args; //arguments of the top frame, in order
+      std::vector<tree::Expression> replacement_stack; //scratch space for instantiating replacements
+      RuleIndex::MatchBuffer match_buffer;
+      auto push_stack_frame = [&](std::size_t result_position, tree::Expression source) {
         //Push the expressions spine and args to the appropriate stacks, and
         //push a stack frame with the requisite information.
         auto head = arg_stack[result_position];
@@ -207,22 +260,34 @@ namespace expression {
           ++arg_count;
         }
         stack.push_back({
+          .source = std::move(source),
+          .spine = arg_stack[result_position],
+          .changed = false,
           .head = std::move(head),
           .arg_count = arg_count,
           .next_arg_to_reduce = next_arg_to_reduce,
           .result_position = result_position
         });
       };
+      auto look_up = [&](std::size_t position) -> ReductionCache::StuckHeads const* {
+        //If the cache has a current normal form for the expression at position, replace it
+        //and return its stuck heads. If the entry is stale, replace the expression with the
+        //old normal form (a reduct of the original) and return nullptr.
+        auto const* entry = cache.find(arg_stack[position]);
+        if(!entry) return nullptr;
+        arg_stack[position] = entry->normal_form;
+        return ctx.is_current(*entry) ? &entry->stuck_heads : nullptr;
+      };
       auto reduce_next_arg = [&] { //returns "true" if current frame is fully reduced
-        auto& stack_top = stack.back();
         std::size_t stack_top_index = stack.size() - 1;
-        while(stack_top.next_arg_to_reduce < arg_stack.size()) {
-          if(memoized_results.contains(arg_stack[stack_top.next_arg_to_reduce])) {
-            arg_stack[stack_top.next_arg_to_reduce] = memoized_results.at(arg_stack[stack_top.next_arg_to_reduce]);
-            ++stack[stack_top_index].next_arg_to_reduce;
+        while(stack[stack_top_index].next_arg_to_reduce < arg_stack.size()) {
+          auto position = stack[stack_top_index].next_arg_to_reduce++;
+          auto source = arg_stack[position];
+          if(auto const* stuck_heads = look_up(position)) {
+            stack[stack_top_index].stuck_heads.merge(*stuck_heads);
+            if(arg_stack[position].data() != source.data()) stack[stack_top_index].changed = true;
           } else {
-            push_stack_frame(stack_top.next_arg_to_reduce);
-            ++stack[stack_top_index].next_arg_to_reduce;
+            push_stack_frame(position, std::move(source));
             return true;
           }
         }
@@ -241,64 +306,110 @@ namespace expression {
         auto& stack_top = stack.back();
         auto& head = stack_top.head;
         if(auto* ext = head.get_if_external()) {
-          auto const& ext_info = ctx.external_info[ext->external_index];
-          for(auto const& rule_info : ext_info.rules) {
-            if(rule_info.arg_count <= stack_top.arg_count) {
-              auto test_pos = recombine_head(head, rule_info.arg_count);
-              auto const& rule = ctx.rules[rule_info.index];
-              if(!filter(rule)) continue;
-              if(term_matches(test_pos, rule.pattern)) {
-                head = substitute_into_replacement(destructure_match(test_pos, rule.pattern), rule.replacement);
-                arg_stack.erase(arg_stack.end() - rule_info.arg_count, arg_stack.end());
-                stack_top.arg_count -= rule_info.arg_count;
-                return true;
-              }
-            }
+          auto external_index = ext->external_index; //head is replaced if a rule fires
+          auto const& ext_info = ctx.external_info[external_index];
+          auto started = ctx.profile ? ReductionProfile::Clock::now() : ReductionProfile::Clock::time_point{};
+          args.clear();
+          for(std::size_t i = 0; i < stack_top.arg_count; ++i) {
+            args.push_back(&arg_stack[arg_stack.size() - i - 1]);
           }
-          for(auto const& rule_info : ext_info.data_rules) {
-            if(rule_info.arg_count <= stack_top.arg_count) {
-              auto test_pos = recombine_head(head, rule_info.arg_count);
-              auto const& rule = ctx.data_rules[rule_info.index];
-              if(term_matches(test_pos, rule.pattern)) {
-                head = rule.replace(destructure_match(test_pos, rule.pattern));
-                arg_stack.erase(arg_stack.end() - rule_info.arg_count, arg_stack.end());
-                stack_top.arg_count -= rule_info.arg_count;
-                return true;
-              }
+          auto candidate = ext_info.rule_index.find(args, match_buffer, [&](RuleIndex::Candidate const& candidate) {
+            return candidate.is_data || filter(ctx.rules[candidate.rule_index]);
+          });
+          if(candidate) {
+            //Drop the matched args first, so the captures are often the only references to their values.
+            arg_stack.erase(arg_stack.end() - candidate->arg_count, arg_stack.end());
+            stack_top.arg_count -= candidate->arg_count;
+            if(candidate->is_data) {
+              head = ctx.data_rules[candidate->rule_index].replace(std::move(match_buffer.captures), ctx);
+            } else {
+              head = ctx.replacement_programs[candidate->rule_index].instantiate(match_buffer.captures, replacement_stack);
+            }
+            if(ctx.profile) {
+              ctx.profile->record_firing(external_index, candidate->is_data, candidate->rule_index, ReductionProfile::Clock::now() - started);
             }
+            stack_top.changed = true;
+            return true;
+          }
+          if(ctx.profile) {
+            ctx.profile->record_failure(external_index, ReductionProfile::Clock::now() - started);
+          }
+          if(!ext_info.is_axiom) {
+            stack_top.stuck_heads.add(external_index);
+          }
+        } else if(auto* data = head.get_if_data()) {
+          //Data built from arbitrary expressions (e.g. vector literals) has its children reduced once.
+          auto reduced = data->data.reduce_children([&](tree::Expression const& child) {
+            return reduce_flat(ctx, child, filter, cache);
+          });
+          if(reduced) {
+            head = std::move(*reduced);
+            stack_top.changed = true;
+            stack_top.stuck_heads.overflow = true; //the children's stuck heads are not tracked
+            return true;
           }
         }
         return false;
       };
       auto pop_stack_frame = [&](bool save_result) {
-        auto& stack_top = stack.back();
-        auto root_head = recombine_head(stack_top.head, stack_top.arg_count);
+        auto stack_top = std::move(stack.back());
+        stack.pop_back();
+        auto root_head = stack_top.changed ? recombine_head(std::move(stack_top.head), stack_top.arg_count) : std::move(stack_top.spine);
         arg_stack.erase(arg_stack.end() - stack_top.arg_count, arg_stack.end());
         if(save_result) {
-          memoized_results.insert(std::make_pair(arg_stack[stack_top.result_position], root_head));
+          ReductionCache::Entry entry{
+            .normal_form = root_head,
+            .epoch = ctx.rule_epoch,
+            .stuck_heads = stack_top.stuck_heads
+          };
+          bool reduced = root_head.data() != stack_top.source.data();
+          if(reduced) {
+            cache.insert(root_head, entry); //normal forms are their own normal forms
+          }
+          cache.insert(stack_top.source, std::move(entry));
+          if(!stack.empty()) {
+            stack.back().stuck_heads.merge(stack_top.stuck_heads);
+            if(reduced) stack.back().changed = true;
+          }
         }
         arg_stack[stack_top.result_position] = std::move(root_head);
-        stack.pop_back();
+        return std::move(stack_top.source);
       };
       auto repush_top_frame = [&] { //pop and push a frame after simplifying
         auto frame_pos = stack.back().result_position;
-        pop_stack_frame(false);
-        push_stack_frame(frame_pos);
+        auto source = pop_stack_frame(false);
+        push_stack_frame(frame_pos, std::move(source));
       };
       /*
         Body
       */
       arg_stack.push_back(tree);
-      push_stack_frame(0);
+      if(look_up(0)) {
+        return std::move(arg_stack[0]);
+      }
+      auto started = ctx.tracer ? mdb::Tracer::Clock::now() : mdb::Tracer::Clock::time_point{};
+      std::uint64_t rules_fired = 0;
+      push_stack_frame(0, std::move(tree));
       while(!stack.empty()) {
         while(reduce_next_arg()); //push args onto stack as long as we can
         //At this point, the top stack frame has reduced all of its args.
         if(find_local_reduction()) {
+          ctx.charge_step();
+          ++rules_fired;
           repush_top_frame();
         } else {
           pop_stack_frame(true);
         }
       }
+      if(ctx.tracer && rules_fired >= ctx.traced_reduction_steps) {
+        ctx.tracer->record({
+          .name = "reduce",
+          .category = "reduce",
+          .start = started,
+          .duration = mdb::Tracer::Clock::now() - started,
+          .args = {{"rules fired", std::to_string(rules_fired)}}
+        });
+      }
       return std::move(arg_stack[0]);
     }
     /*
@@ -365,10 +476,96 @@ namespace expression {
       2. re-use results of these matches
   */
   tree::Expression Context::reduce(tree::Expression tree) {
-    return reduce_flat(*this, std::move(tree), [](auto&&) { return true; });
+    return reduce_flat(*this, std::move(tree), [](auto&&) { return true; }, reduction_cache);
+  }
+  tree::Expression Context::reduce(tree::Expression tree, Budget& budget) {
+    BudgetScope scope{this->budget, &budget};
+    return reduce(std::move(tree));
   }
   tree::Expression Context::reduce_filter_rules(tree::Expression tree, mdb::function<bool(Rule const&)> filter) {
-    return reduce_flat(*this, std::move(tree), std::move(filter));
+    //Results depend on the filter, so they cannot be shared with other reductions.
+    ReductionCache local_cache{std::numeric_limits<std::size_t>::max()};
+    return reduce_flat(*this, std::move(tree), std::move(filter), local_cache);
+  }
+  tree::Expression Context::reduce_whnf(tree::Expression tree) {
+    std::vector<tree::Expression const*> args;
+    std::vector<tree::Expression> replacement_stack;
+    RuleIndex::MatchBuffer match_buffer;
+    while(true) {
+      if(auto const* entry = reduction_cache.find(tree)) {
+        bool current = is_current(*entry);
+        tree = entry->normal_form;
+        if(current) return tree;
+      }
+      auto const* ext = spine_head(tree).get_if_external();
+      if(!ext) return tree;
+      auto head = ext->external_index;
+      if(external_info[head].rules.empty() && external_info[head].data_rules.empty()) return tree;
+      auto unfolded = unfold(std::move(tree));
+      args.clear();
+      for(std::size_t i = 0; i < unfolded.args.size(); ++i) {
+        auto& arg = unfolded.args[i];
+        if(external_info[head].rule_index.inspects(i)) arg = reduce(std::move(arg)); //captured arguments are left for the replacement
+        args.push_back(&arg);
+      }
+      auto started = profile ? ReductionProfile::Clock::now() : ReductionProfile::Clock::time_point{};
+      auto candidate = external_info[head].rule_index.find(args, match_buffer, [](RuleIndex::Candidate const&) { return true; });
+      if(!candidate) {
+        if(profile) profile->record_failure(head, ReductionProfile::Clock::now() - started);
+        return std::move(unfolded).fold();
+      }
+      charge_step();
+      if(candidate->is_data) {
+        tree = data_rules[candidate->rule_index].replace(std::move(match_buffer.captures), *this);
+      } else {
+        tree = replacement_programs[candidate->rule_index].instantiate(match_buffer.captures, replacement_stack);
+      }
+      if(profile) profile->record_firing(head, candidate->is_data, candidate->rule_index, ReductionProfile::Clock::now() - started);
+      for(auto i = candidate->arg_count; i < unfolded.args.size(); ++i) {
+        tree = tree::Apply{std::move(tree), std::move(unfolded.args[i])};
+      }
+    }
+  }
+  bool Context::is_current(ReductionCache::Entry const& entry) const {
+    if(entry.epoch == rule_epoch) return true;
+    if(entry.stuck_heads.overflow) return false;
+    for(std::uint8_t i = 0; i < entry.stuck_heads.count; ++i) {
+      if(external_info[entry.stuck_heads.heads[i]].rule_epoch > entry.epoch) return false;
+    }
+    return true;
+  }
+  namespace {
+    bool matches_rule_prefix(Context const& ctx, tree::Expression const& expr, bool lambda_like) {
+      std::uint64_t arg_count = 0;
+      tree::Expression const* head = &expr;
+      while(auto* apply = head->get_if_apply()) {
+        head = &apply->lhs;
+        ++arg_count;
+      }
+      auto* external = head->get_if_external();
+      if(!external) return false;
+      auto const& info = ctx.external_info[external->external_index];
+      if(arg_count >= info.arities.size()) return false;
+      auto const& arity = info.arities[arg_count];
+      if(lambda_like ? arity.lambda_like : arity.partial) return true;
+      if(!(lambda_like ? arity.lambda_like_if_matching : arity.partial_if_matching)) return false;
+      for(auto const& rule_info : info.rules) {
+        if(rule_info.arg_count <= arg_count) continue;
+        if(lambda_like && arg_count + rule_info.trailing_wildcards < rule_info.arg_count) continue;
+        pattern::Pattern const* prefix = &ctx.rules[rule_info.index].pattern;
+        for(std::uint64_t i = arg_count; i < rule_info.arg_count; ++i) {
+          prefix = &prefix->get_apply().lhs;
+        }
+        if(term_matches(expr, *prefix)) return true;
+      }
+      return false;
+    }
+  }
+  bool Context::needs_more_arguments(tree::Expression const& expr) const {
+    return matches_rule_prefix(*this, expr, false);
+  }
+  bool Context::is_lambda_like(tree::Expression const& expr) const {
+    return matches_rule_prefix(*this, expr, true);
   }
   TypedValue Context::get_external(std::uint64_t i) {
     return {
@@ -380,37 +577,300 @@ namespace expression {
     auto index = rules.size();
     auto head = get_pattern_head(rule.pattern);
     auto args = count_pattern_args(rule.pattern);
+    replacement_programs.emplace_back(rule.replacement);
     rules.push_back(std::move(rule));
-    external_info[head].rules.push_back({
+    auto& rule_info = external_info[head].rules.emplace_back(ExternalInfo::RuleInfo{
       .index = index,
       .arg_count = args
     });
+    fill_wildcard_counts(rule_info, rules.back().pattern);
+    add_arities(external_info[head], rule_info);
+    external_info[head].rule_index.add(rules.back().pattern, {
+      .rank = RuleIndex::rank_of(false, index),
+      .is_data = false,
+      .rule_index = index,
+      .arg_count = args
+    });
+    note_rule_added(*this, head);
   }
   void Context::replace_rule(std::size_t index, Rule new_rule) {
     auto head = get_pattern_head(new_rule.pattern);
     auto args = count_pattern_args(new_rule.pattern);
     for(auto& rule_info : external_info[head].rules) {
       if(rule_info.index == index) {
+        replacement_programs[index] = ReplacementProgram{new_rule.replacement};
         rules[index] = std::move(new_rule);
         rule_info.arg_count = args;
+        fill_wildcard_counts(rule_info, rules[index].pattern);
+        rebuild_rule_index(*this, head);
+        reduction_cache.clear();
+        rule_events.push_back(head);
         return;
       }
     }
     std::terminate(); //o no
   }
+  namespace {
+    void collect_externals(tree::Expression const& expr, std::vector<std::uint64_t>& externals) {
+      expr.visit(mdb::overloaded{
+        [&](tree::Apply const& apply) {
+          collect_externals(apply.lhs, externals);
+          collect_externals(apply.rhs, externals);
+        },
+        [&](tree::External const& external) { externals.push_back(external.external_index); },
+        [&](tree::Arg const&) {},
+        [&](tree::Data const& data) {
+          data.data.visit_children([&](tree::Expression const& child) { collect_externals(child, externals); });
+        }
+      });
+    }
+    void collect_externals(data_pattern::Pattern const& pattern, std::vector<std::uint64_t>& externals) {
+      pattern.visit(mdb::overloaded{
+        [&](data_pattern::Apply const& apply) {
+          collect_externals(apply.lhs, externals);
+          collect_externals(apply.rhs, externals);
+        },
+        [&](data_pattern::Fixed const& fixed) { externals.push_back(fixed.external_index); },
+        [&](data_pattern::Wildcard const&) {},
+        [&](data_pattern::Data const&) {}
+      });
+    }
+    void insert_data_rule(Context& ctx, DataRule rule, std::uint64_t pin) {
+      auto index = ctx.data_rules.size();
+      auto head = get_pattern_head(rule.pattern);
+      auto args = count_pattern_args(rule.pattern);
+      ctx.data_rules.push_back(std::move(rule));
+      ctx.data_rule_pins.push_back(pin);
+      ctx.external_info[head].data_rules.push_back({
+        .index = index,
+        .arg_count = args
+      });
+      ctx.external_info[head].rule_index.add(ctx.data_rules.back().pattern, {
+        .rank = RuleIndex::rank_of(true, index),
+        .is_data = true,
+        .rule_index = index,
+        .arg_count = args
+      });
+      note_rule_added(ctx, head);
+    }
+  }
   void Context::add_data_rule(DataRule rule) {
-    auto index = data_rules.size();
-    auto head = get_pattern_head(rule.pattern);
-    auto args = count_pattern_args(rule.pattern);
-    data_rules.push_back(std::move(rule));
-    external_info[head].data_rules.push_back({
-      .index = index,
-      .arg_count = args
-    });
+    insert_data_rule(*this, std::move(rule), external_info.size());
+  }
+  void Context::add_data_rule(DataRule rule, std::span<std::uint64_t const> captures) {
+    std::vector<std::uint64_t> mentioned(captures.begin(), captures.end());
+    collect_externals(rule.pattern, mentioned);
+    std::uint64_t pin = 0;
+    for(auto external : mentioned) pin = std::max<std::uint64_t>(pin, external + 1);
+    insert_data_rule(*this, std::move(rule), pin);
+  }
+  auto Context::checkpoint() const -> Checkpoint {
+    return {
+      .external_count = external_info.size(),
+      .rule_count = rules.size(),
+      .data_rule_count = data_rules.size()
+    };
+  }
+  void Context::rollback(Checkpoint checkpoint) {
+    std::unordered_set<std::uint64_t> touched_heads; //older externals which gained rules since the checkpoint
+    for(std::size_t i = checkpoint.rule_count; i < rules.size(); ++i) {
+      auto head = get_pattern_head(rules[i].pattern);
+      if(head < checkpoint.external_count) touched_heads.insert(head);
+    }
+    for(std::size_t i = checkpoint.data_rule_count; i < data_rules.size(); ++i) {
+      auto head = get_pattern_head(data_rules[i].pattern);
+      if(head < checkpoint.external_count) touched_heads.insert(head);
+    }
+    external_info.erase(external_info.begin() + checkpoint.external_count, external_info.end());
+    rules.erase(rules.begin() + checkpoint.rule_count, rules.end());
+    replacement_programs.erase(replacement_programs.begin() + checkpoint.rule_count, replacement_programs.end());
+    data_rules.erase(data_rules.begin() + checkpoint.data_rule_count, data_rules.end());
+    data_rule_pins.erase(data_rule_pins.begin() + checkpoint.data_rule_count, data_rule_pins.end());
+    for(auto head : touched_heads) {
+      auto& info = external_info[head];
+      std::erase_if(info.rules, [&](auto const& rule_info) { return rule_info.index >= checkpoint.rule_count; });
+      std::erase_if(info.data_rules, [&](auto const& rule_info) { return rule_info.index >= checkpoint.data_rule_count; });
+      rebuild_rule_index(*this, head);
+      info.rule_epoch = ++rule_epoch;
+    }
+    reduction_cache.clear();
+    rule_events.clear(); //any solver reading these belonged to the discarded work
+    if(profile) {
+      profile->heads.resize(std::min(profile->heads.size(), checkpoint.external_count));
+      profile->rules.resize(std::min(profile->rules.size(), checkpoint.rule_count));
+      profile->data_rules.resize(std::min(profile->data_rules.size(), checkpoint.data_rule_count));
+    }
+  }
+  namespace {
+    struct ExternalRemapper {
+      Context::Compaction const& compaction;
+      std::unordered_map<void const*, tree::Expression> memo; //trees are shared, so a node may be reached many times
+      tree::Expression remap(tree::Expression const& expr) {
+        if(auto it = memo.find(expr.data()); it != memo.end()) return it->second;
+        auto ret = expr.visit(mdb::overloaded{
+          [&](tree::Apply const& apply) -> tree::Expression {
+            return tree::Apply{remap(apply.lhs), remap(apply.rhs)};
+          },
+          [&](tree::External const& external) -> tree::Expression {
+            return tree::External{*compaction.remap(external.external_index)};
+          },
+          [&](tree::Arg const&) -> tree::Expression {
+            return expr;
+          },
+          [&](tree::Data const& data) -> tree::Expression {
+            return data.data.map_children([&](tree::Expression const& child) { return remap(child); });
+          }
+        });
+        memo.insert(std::make_pair(expr.data(), ret));
+        return ret;
+      }
+      pattern::Pattern remap(pattern::Pattern const& pat) {
+        return pat.visit(mdb::overloaded{
+          [&](pattern::Apply const& apply) -> pattern::Pattern {
+            return pattern::Apply{remap(apply.lhs), remap(apply.rhs)};
+          },
+          [&](pattern::Fixed const& fixed) -> pattern::Pattern {
+            return pattern::Fixed{*compaction.remap(fixed.external_index)};
+          },
+          [&](pattern::Wildcard const&) -> pattern::Pattern {
+            return pattern::Wildcard{};
+          }
+        });
+      }
+    };
+  }
+  auto Context::compact(Checkpoint checkpoint, std::span<tree::Expression* const> roots) -> Compaction {
+    auto base = checkpoint.external_count;
+    std::vector<DataRule> new_data_rules;
+    std::vector<std::uint64_t> new_data_rule_pins;
+    std::vector<ReductionProfile::RuleCounts> new_data_rule_counts;
+    if(data_rules.size() > checkpoint.data_rule_count) {
+      //Types of externals kept in place are not remapped, so what they mention is kept too.
+      std::vector<std::uint64_t> mentioned;
+      for(std::size_t i = checkpoint.data_rule_count; i < data_rules.size(); ++i) {
+        base = std::max<std::uint64_t>(base, data_rule_pins[i]);
+      }
+      for(auto scanned = checkpoint.external_count; scanned < base; ++scanned) {
+        collect_externals(external_info[scanned].type, mentioned);
+        for(auto external : mentioned) base = std::max<std::uint64_t>(base, external + 1);
+        mentioned.clear();
+      }
+      for(std::size_t i = checkpoint.data_rule_count; i < data_rules.size(); ++i) {
+        new_data_rule_pins.push_back(data_rule_pins[i]);
+        new_data_rules.push_back({
+          .pattern = data_rules[i].pattern, //rollback still reads the pattern
+          .replace = std::move(data_rules[i].replace)
+        });
+        if(profile) new_data_rule_counts.push_back(i < profile->data_rules.size() ? profile->data_rules[i] : ReductionProfile::RuleCounts{});
+      }
+      checkpoint.external_count = base;
+    }
+    struct Detail {
+      std::uint64_t base;
+      std::vector<bool> reachable;
+      std::vector<std::uint64_t> pending;
+      std::unordered_set<void const*> visited;
+      void mark(tree::Expression const& expr) {
+        if(!visited.insert(expr.data()).second) return;
+        expr.visit(mdb::overloaded{
+          [&](tree::Apply const& apply) {
+            mark(apply.lhs);
+            mark(apply.rhs);
+          },
+          [&](tree::External const& external) {
+            auto index = external.external_index;
+            if(index >= base && !reachable[index - base]) {
+              reachable[index - base] = true;
+              pending.push_back(index);
+            }
+          },
+          [&](tree::Arg const&) {},
+          [&](tree::Data const& data) {
+            data.data.visit_children([&](tree::Expression const& child) { mark(child); });
+          }
+        });
+      }
+    };
+    Detail detail{.base = base, .reachable = std::vector<bool>(external_info.size() - base, false)};
+    auto& reachable = detail.reachable;
+    auto& pending = detail.pending;
+    auto mark = [&](tree::Expression const& expr) { detail.mark(expr); };
+    auto mark_rule = [&](Rule const& rule) {
+      mark(trivial_replacement_for(rule.pattern));
+      mark(rule.replacement);
+    };
+    for(auto* root : roots) {
+      mark(*root);
+    }
+    for(std::size_t i = checkpoint.rule_count; i < rules.size(); ++i) {
+      if(get_pattern_head(rules[i].pattern) < base) mark_rule(rules[i]);
+    }
+    while(!pending.empty()) {
+      auto index = pending.back();
+      pending.pop_back();
+      mark(external_info[index].type);
+      for(auto const& rule_info : external_info[index].rules) {
+        mark_rule(rules[rule_info.index]);
+      }
+    }
+
+    Compaction compaction{.first_remapped = base};
+    std::uint64_t next_index = base;
+    for(bool survives : reachable) {
+      if(survives) compaction.new_index.push_back(next_index++);
+      else compaction.new_index.push_back(std::nullopt);
+    }
+    ExternalRemapper remapper{compaction};
+    std::vector<ExternalInfo> surviving_externals;
+    for(std::uint64_t i = 0; i < reachable.size(); ++i) {
+      if(!reachable[i]) continue;
+      surviving_externals.push_back({
+        .is_axiom = external_info[base + i].is_axiom,
+        .type = remapper.remap(external_info[base + i].type)
+      });
+    }
+    std::vector<Rule> surviving_rules;
+    std::vector<ReductionProfile::RuleCounts> surviving_rule_counts;
+    for(std::size_t i = checkpoint.rule_count; i < rules.size(); ++i) {
+      if(!compaction.remap(get_pattern_head(rules[i].pattern))) continue;
+      surviving_rules.push_back({
+        .pattern = remapper.remap(rules[i].pattern),
+        .replacement = remapper.remap(rules[i].replacement)
+      });
+      if(profile) surviving_rule_counts.push_back(i < profile->rules.size() ? profile->rules[i] : ReductionProfile::RuleCounts{});
+    }
+    std::vector<ReductionProfile::HeadCounts> surviving_head_counts;
+    if(profile) {
+      for(std::size_t i = 0; i < reachable.size(); ++i) {
+        if(reachable[i]) surviving_head_counts.push_back(base + i < profile->heads.size() ? profile->heads[base + i] : ReductionProfile::HeadCounts{});
+      }
+    }
+    for(auto* root : roots) {
+      *root = remapper.remap(*root);
+    }
+    rollback(checkpoint);
+    for(auto& info : surviving_externals) {
+      external_info.push_back(std::move(info));
+    }
+    for(auto& rule : surviving_rules) {
+      add_rule(std::move(rule));
+    }
+    for(std::size_t i = 0; i < new_data_rules.size(); ++i) {
+      insert_data_rule(*this, std::move(new_data_rules[i]), new_data_rule_pins[i]);
+    }
+    if(profile) {
+      profile->data_rules.resize(checkpoint.data_rule_count);
+      profile->data_rules.insert(profile->data_rules.end(), new_data_rule_counts.begin(), new_data_rule_counts.end());
+      profile->heads.resize(base);
+      profile->heads.insert(profile->heads.end(), surviving_head_counts.begin(), surviving_head_counts.end());
+      profile->rules.resize(checkpoint.rule_count);
+      profile->rules.insert(profile->rules.end(), surviving_rule_counts.begin(), surviving_rule_counts.end());
+    }
+    return compaction;
   }
 
   std::optional<Context::FunctionData> Context::get_domain_and_codomain(tree::Expression in) {
-    in = reduce(std::move(in));
+    in = reduce_whnf(std::move(in));
     if(auto* lhs_apply = in.get_if_apply()) {
       if(auto* inner_apply = lhs_apply->lhs.get_if_apply()) {
         if(auto* lhs_ext = inner_apply->lhs.get_if_external()) {
@@ -2,8 +2,18 @@
 #define EVALUATION_CONTEXT_HPP
 
 #include "expression_tree.hpp"
+#include "reduction_cache.hpp"
+#include "rule_index.hpp"
+#include "replacement_program.hpp"
+#include "budget.hpp"
+#include "reduction_profile.hpp"
+#include "../Utility/trace.hpp"
+#include <span>
 
 namespace expression {
+  namespace data {
+    class Vector;
+  }
   constexpr auto lambda_pattern = [](std::uint64_t head, std::uint64_t args) {
     pattern::Pattern ret = pattern::Fixed{head};
     for(std::uint64_t i = 0; i < args; ++i) {
@@ -21,9 +31,20 @@ namespace expression {
     struct RuleInfo {
       std::uint64_t index;
       std::uint64_t arg_count;
+      std::uint64_t leading_wildcards = 0; //number of initial arguments which are wildcards
+      std::uint64_t trailing_wildcards = 0; //number of final arguments which are wildcards
+    };
+    struct ArityInfo { //whether a term with a given number of arguments is a prefix of some rule
+      bool partial = false; //of a rule whose matched arguments are all wildcards
+      bool partial_if_matching = false; //of a rule with a pattern to check
+      bool lambda_like = false; //as partial, but only counting rules whose missing arguments are all wildcards
+      bool lambda_like_if_matching = false;
     };
     std::vector<RuleInfo> rules;
     std::vector<RuleInfo> data_rules;
+    std::vector<ArityInfo> arities; //indexed by argument count; only covers rules, not data rules
+    RuleIndex rule_index; //indexes both rules and data_rules
+    std::uint64_t rule_epoch = 0; //epoch at which a rule was last added for this external
   };
   struct Primitives {
     std::uint64_t type;
@@ -37,26 +58,74 @@ namespace expression {
     std::uint64_t id; // \T:Type.\t:T.t
     std::uint64_t id_codomain;
     std::uint64_t arrow_codomain;
-    std::uint64_t push_vec = -1; //set externally, for now
-    std::uint64_t empty_vec = -1;
+    data::Vector const* vector = nullptr; //set externally, for now; builds vector literals
   };
   struct Context {
     std::vector<Rule> rules;
+    std::vector<ReplacementProgram> replacement_programs; //compiled from each rule's replacement
     std::vector<DataRule> data_rules;
+    std::vector<std::uint64_t> data_rule_pins; //by data rule: externals below this keep their indices through compaction
     std::vector<ExternalInfo> external_info;
     Primitives primitives;
+    std::uint64_t rule_epoch = 0; //incremented whenever a rule is added
+    std::vector<std::uint64_t> rule_events; //head of every rule added or replaced, in order
+    ReductionCache reduction_cache;
+    Budget* budget = nullptr; //charged by every reduction while set; see BudgetScope
+    std::optional<ReductionProfile> profile; //collected by every reduction while engaged; kept in step with rollback and compaction
+    mdb::Tracer* tracer = nullptr; //receives compile, solver and reduction spans while set
+    std::uint64_t traced_reduction_steps = 1000; //reductions firing fewer rules than this are not traced
     Context();
     TypedValue get_external(std::uint64_t);
     void add_rule(Rule);
     void replace_rule(std::size_t index, Rule new_rule);
-    void add_data_rule(DataRule);
+    void add_data_rule(DataRule); //pins every existing external, as the callback may capture any of them
+    void add_data_rule(DataRule, std::span<std::uint64_t const> captures); //pins only those in the pattern and captures
     tree::Expression reduce(tree::Expression tree);
+    tree::Expression reduce(tree::Expression tree, Budget&); //throws BudgetExceeded
+    /*
+      Reduces only until the spine is stuck. The result has the head and
+      argument count of the normal form, but arguments are normalized only
+      when a rule for the head needs them to be matched - the arguments of an
+      axiom, for instance, are left as they are.
+    */
+    tree::Expression reduce_whnf(tree::Expression tree);
     tree::Expression reduce_filter_rules(tree::Expression tree, mdb::function<bool(Rule const&)> filter);
+    bool is_current(ReductionCache::Entry const&) const;
+    void charge_step() { if(budget) budget->charge_step(); }
+    /*
+      A checkpoint marks the externals and rules which existed at some point.
+      Rolling back to it discards everything created since; compacting to it
+      discards only what cannot be reached from the given roots - the types
+      and rules of reachable externals being reachable too. Survivors are
+      renumbered to close the gaps and the roots are rewritten to match.
+
+      Data rules hold opaque callbacks which cannot be renumbered, so each
+      pins the externals it may refer to. Those, every external before them,
+      and whatever their types mention keep their indices and survive.
+    */
+    struct Checkpoint {
+      std::size_t external_count;
+      std::size_t rule_count;
+      std::size_t data_rule_count;
+    };
+    struct Compaction {
+      std::uint64_t first_remapped; //externals below this index are unchanged
+      std::vector<std::optional<std::uint64_t> > new_index; //of each later external; empty if discarded
+      std::optional<std::uint64_t> remap(std::uint64_t external) const {
+        if(external < first_remapped) return external;
+        return new_index[external - first_remapped];
+      }
+    };
+    Checkpoint checkpoint() const;
+    void rollback(Checkpoint);
+    Compaction compact(Checkpoint, std::span<tree::Expression* const> roots);
+    bool needs_more_arguments(tree::Expression const&) const; //if the term matches a proper prefix of some rule's pattern
+    bool is_lambda_like(tree::Expression const&) const; //as above, but only for prefixes missing only wildcards
     struct FunctionData {
       tree::Expression domain;
       tree::Expression codomain;
     };
-    std::optional<FunctionData> get_domain_and_codomain(tree::Expression);
+    std::optional<FunctionData> get_domain_and_codomain(tree::Expression); //domain and codomain are not normalized
     template<std::uint64_t count, class Callback> decltype(auto) create_variables(Callback&& callback) {
       bool called_build = false;
       decltype(auto) ret = [&]<std::uint64_t... indices>(std::integer_sequence<std::uint64_t, indices...>) {
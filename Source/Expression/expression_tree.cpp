@@ -2,11 +2,20 @@
 #include <algorithm>
 
 namespace expression {
+  std::optional<tree::Expression> peel_data(tree::Expression const& term) {
+    if(auto* data = term.get_if_data()) {
+      return data->data.peel();
+    } else {
+      return std::nullopt;
+    }
+  }
   bool term_matches(tree::Expression const& term, pattern::Pattern const& pattern) {
     return pattern.visit(mdb::overloaded{
       [&](pattern::Apply const& apply) {
         if(auto* app = term.get_if_apply()) {
           return term_matches(app->lhs, apply.lhs) && term_matches(app->rhs, apply.rhs);
+        } else if(auto peeled = peel_data(term)) {
+          return term_matches(*peeled, pattern);
         } else {
           return false;
         }
@@ -28,6 +37,8 @@ namespace expression {
       [&](data_pattern::Apply const& apply) {
         if(auto* app = term.get_if_apply()) {
           return term_matches(app->lhs, apply.lhs) && term_matches(app->rhs, apply.rhs);
+        } else if(auto peeled = peel_data(term)) {
+          return term_matches(*peeled, pattern);
         } else {
           return false;
         }
@@ -85,6 +96,8 @@ namespace expression {
             if(auto* app = term.get_if_apply()) {
               examine(app->lhs, apply.lhs);
               examine(app->rhs, apply.rhs);
+            } else if(auto peeled = peel_data(term)) {
+              examine(*peeled, p);
             } else {
               throw NoMatchException{};
             }
@@ -109,6 +122,8 @@ namespace expression {
             if(auto* app = term.get_if_apply()) {
               examine(app->lhs, apply.lhs);
               examine(app->rhs, apply.rhs);
+            } else if(auto peeled = peel_data(term)) {
+              examine(*peeled, p);
             } else {
               throw NoMatchException{};
             }
@@ -228,15 +243,29 @@ namespace expression {
 
   Unfolding unfold(tree::Expression tree) {
     Unfolding ret{
-      .head = std::move(tree)
+      .head = spine_head(tree)
     };
-    while(auto* app = ret.head.get_if_apply()) {
-      ret.args.push_back(std::move(app->rhs));
-      ret.head = std::move(app->lhs);
+    ret.args.reserve(spine_arg_count(tree));
+    for(tree::Expression const* position = &tree; auto* app = position->get_if_apply(); position = &app->lhs) {
+      ret.args.push_back(app->rhs);
     }
     std::reverse(ret.args.begin(), ret.args.end());
     return ret;
   }
+  tree::Expression const& spine_head(tree::Expression const& tree) {
+    tree::Expression const* head = &tree;
+    while(auto* app = head->get_if_apply()) {
+      head = &app->lhs;
+    }
+    return *head;
+  }
+  std::uint64_t spine_arg_count(tree::Expression const& tree) {
+    std::uint64_t ret = 0;
+    for(tree::Expression const* head = &tree; auto* app = head->get_if_apply(); head = &app->lhs) {
+      ++ret;
+    }
+    return ret;
+  }
 
   indexed_pattern::Pattern index_pattern(pattern::Pattern const& p) {
     struct Detail {
@@ -7,6 +7,7 @@
 #include "../Utility/function.hpp"
 
 namespace expression {
+  std::optional<tree::Expression> peel_data(tree::Expression const&); //the constructor application a data term stands for, if any
   bool term_matches(tree::Expression const&, pattern::Pattern const&);
   bool term_matches(tree::Expression const&, data_pattern::Pattern const&);
   struct NoMatchException : std::runtime_error {
@@ -44,14 +45,18 @@ namespace expression {
     tree::Expression fold() &&;
   };
   Unfolding unfold(tree::Expression);
+  tree::Expression const& spine_head(tree::Expression const&); //the head of the unfolding, found without copying
+  std::uint64_t spine_arg_count(tree::Expression const&); //the number of args in the unfolding
 
   struct Rule {
     pattern::Pattern pattern;
     tree::Expression replacement;
   };
+  struct Context;
   struct DataRule {
     data_pattern::Pattern pattern;
-    mdb::function<tree::Expression(std::vector<tree::Expression>)> replace;
+    //The context is passed so that natives may reduce eagerly. It reduces with every rule, even under a filter.
+    mdb::function<tree::Expression(std::vector<tree::Expression>, Context&)> replace;
   };
 
   indexed_pattern::Pattern index_pattern(pattern::Pattern const&);
@@ -27,7 +27,11 @@ output = shape.generate_instance(namespace = "expression::tree", data = {
 })
 tree_def = TreeOutput(
     trees = [output],
-    shared = True
+    shared = True,
+    interned = True,
+    inline_leaves = True,
+    atomic_reference_counts = False,
+    node_pool = True
 )
 
 main_output = get_output("THIS_impl")
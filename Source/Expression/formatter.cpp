@@ -24,19 +24,32 @@ namespace expression::format {
         });
       }
       bool treat_as_lambda(tree::Expression const& expr) {
-        for(auto const& rule : context.expression_context.rules) {
-          if(context.force_expansion(get_pattern_head(rule.pattern))) {
-            pattern::Pattern const* segment = &rule.pattern;
-            while(auto* apply = segment->get_if_apply()) {
-              if(!apply->rhs.holds_wildcard()) break;
-              segment = &apply->lhs;
-              if(term_matches(expr, *segment)) {
-                return true;
-              }
-            }
-          }
+        tree::Expression const* head = &expr;
+        while(auto* apply = head->get_if_apply()) {
+          head = &apply->lhs;
         }
-        return false;
+        auto* external = head->get_if_external();
+        return external && context.force_expansion(external->external_index) && context.expression_context.is_lambda_like(expr);
+      }
+      Response write_apply(tree::Apply apply, Options options) {
+        if(options.parenthesize_application) options.o << "(";
+        auto response = write_expression(std::move(apply.lhs), {
+          .o = options.o,
+          .parenthesize_application = false,
+          .parenthesize_lambda = true,
+          .parenthesize_arrow = true,
+          .arg_count = options.arg_count
+        });
+        options.o << " ";
+        response.merge(write_expression(std::move(apply.rhs), {
+          .o = options.o,
+          .parenthesize_application = true,
+          .parenthesize_lambda = !options.parenthesize_application,
+          .parenthesize_arrow = true,
+          .arg_count = options.arg_count
+        }));
+        if(options.parenthesize_application) options.o << ")";
+        return response;
       }
       Response write_expression(tree::Expression expr, Options options) {
         expr = reduce_legal(std::move(expr));
@@ -97,24 +110,7 @@ namespace expression::format {
         }
         return expr.visit(mdb::overloaded{
           [&](tree::Apply apply) {
-            if(options.parenthesize_application) options.o << "(";
-            auto response = write_expression(std::move(apply.lhs), {
-              .o = options.o,
-              .parenthesize_application = false,
-              .parenthesize_lambda = true,
-              .parenthesize_arrow = true,
-              .arg_count = options.arg_count
-            });
-            options.o << " ";
-            response.merge(write_expression(std::move(apply.rhs), {
-              .o = options.o,
-              .parenthesize_application = true,
-              .parenthesize_lambda = !options.parenthesize_application,
-              .parenthesize_arrow = true,
-              .arg_count = options.arg_count
-            }));
-            if(options.parenthesize_application) options.o << ")";
-            return response;
+            return write_apply(std::move(apply), options);
           },
           [&](tree::Arg arg) {
             Response response{
@@ -128,6 +124,42 @@ namespace expression::format {
             return Response{};
           },
           [&](tree::Data data) {
+            if(auto peeled = data.data.peel()) { //written without reducing, which would pack it again
+              //As write_apply, but a loop rather than recursion, since the chain may be very long.
+              Response response{};
+              bool parenthesize = options.parenthesize_application;
+              std::uint64_t open = 0;
+              while(true) {
+                tree::Apply apply = peeled->get_apply();
+                if(parenthesize) {
+                  options.o << "(";
+                  ++open;
+                }
+                response.merge(write_expression(std::move(apply.lhs), {
+                  .o = options.o,
+                  .parenthesize_application = false,
+                  .parenthesize_lambda = true,
+                  .parenthesize_arrow = true,
+                  .arg_count = options.arg_count
+                }));
+                options.o << " ";
+                auto* inner = apply.rhs.get_if_data();
+                peeled = inner ? inner->data.peel() : std::nullopt;
+                if(!peeled) {
+                  response.merge(write_expression(std::move(apply.rhs), {
+                    .o = options.o,
+                    .parenthesize_application = true,
+                    .parenthesize_lambda = !parenthesize,
+                    .parenthesize_arrow = true,
+                    .arg_count = options.arg_count
+                  }));
+                  break;
+                }
+                parenthesize = true;
+              }
+              options.o << std::string(open, ')');
+              return response;
+            }
             Response ret{};
             data.data.pretty_print(options.o, [&](tree::Expression sub_expr) {
               ret.merge(write_expression(std::move(sub_expr), {
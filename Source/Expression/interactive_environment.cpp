@@ -10,6 +10,10 @@
 #include "standard_solver_context.hpp"
 #include "solve_routine.hpp"
 #include "formatter.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iterator>
 #include <sstream>
 #include <unordered_map>
 #include <map>
@@ -39,8 +43,9 @@ namespace expression::interactive {
       std::uint64_t rule_begin;
       std::uint64_t rule_end;
       solver::ErrorInfo error_info;
+      std::vector<std::uint64_t> unbound_packed_nats; //indices into evaluate_result.packed_nats
 
-      bool is_solved() const { return error_info.failed_equations.empty() && error_info.unconstrainable_patterns.empty(); }
+      bool is_solved() const { return error_info.failed_equations.empty() && error_info.unconstrainable_patterns.empty() && unbound_packed_nats.empty(); }
       std::optional<std::string_view> get_explicit_name(std::uint64_t ext_index) const {
         namespace explanation = compiler::evaluate::variable_explanation;
         if(!evaluate_result.variables.contains(ext_index)) return std::nullopt;
@@ -115,24 +120,74 @@ namespace expression::interactive {
         return values;
       }
     };
+    struct BudgetFailure {
+      BudgetExceeded exceeded;
+      std::uint64_t discarded_externals;
+      std::uint64_t discarded_rules;
+    };
+    template<class Archive>
+    std::uint64_t count_nodes(Archive& archive) {
+      std::uint64_t ret = 0;
+      for([[maybe_unused]] auto index : archive.all_indices()) ++ret;
+      return ret;
+    }
+    class PhaseMeasurement { //adds to the stats of a phase when it ends, even by an exception; traced if the context has a tracer
+      PhaseStats& stats;
+      Context const& context;
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      std::uint64_t allocations = mdb::node_pool.allocation_count;
+      std::size_t externals = context.external_info.size();
+      std::size_t rules = context.rules.size() + context.data_rules.size();
+      mdb::Tracer::Span span;
+    public:
+      PhaseMeasurement(PhaseStats& stats, Context const& context, char const* phase):stats(stats),context(context),span(context.tracer, phase, "compile") {}
+      PhaseMeasurement(PhaseMeasurement const&) = delete;
+      PhaseMeasurement& operator=(PhaseMeasurement const&) = delete;
+      ~PhaseMeasurement() {
+        if(span) span.arg("output nodes", stats.output_nodes);
+        stats.time += std::chrono::steady_clock::now() - start;
+        stats.node_allocations += mdb::node_pool.allocation_count - allocations;
+        stats.externals_created += context.external_info.size() - externals;
+        stats.rules_created += context.rules.size() + context.data_rules.size() - rules;
+      }
+    };
+    void print_budget_failure(std::ostream& output, BudgetFailure const& failure) {
+      output << red_string("Budget exceeded: ");
+      switch(failure.exceeded.reason) {
+        case BudgetExceeded::Reason::steps: output << "step limit reached"; break;
+        case BudgetExceeded::Reason::nodes: output << "node limit reached"; break;
+        case BudgetExceeded::Reason::cancelled: output << "cancelled"; break;
+      }
+      output << " after " << failure.exceeded.steps << " steps and " << failure.exceeded.nodes << " node allocations.\n";
+      output << "Discarded " << failure.discarded_externals << " externals and " << failure.discarded_rules << " rules created by the compilation.\n";
+    }
   }
   struct Environment::Impl {
     expression::Context expression_context;
     expression::data::SmallScalar<std::uint64_t> u64;
     expression::data::SmallScalar<imported_type::StringHolder> str;
+    expression::data::SmallScalar<imported_type::BigInt> big;
+    std::vector<expression::data::PackedNat> packed_nats;
+    std::vector<expression::data::PackedNat> spare_packed_nats; //unbound by rollback; rebound before registering another type
     std::unordered_map<std::string, TypedValue> names_to_values;
     std::unordered_map<std::uint64_t, std::string> externals_to_names;
+    Context::Checkpoint compacted_until; //everything before this survived the last compaction
+    CompileStats last_stats;
+    bool print_stats = false; //written by debug_parse after each result
     void name_external(std::string name, std::uint64_t ext) {
       externals_to_names.insert(std::make_pair(ext, name));
       names_to_values.insert(std::make_pair(name, expression_context.get_external(ext)));
     }
-    Impl():u64(expression_context), str(expression_context) {
+    Impl():u64(expression_context), str(expression_context), big(expression_context) {
       name_external("Type", expression_context.primitives.type);
       name_external("arrow", expression_context.primitives.arrow);
       name_external("U64", u64.get_type_axiom());
       name_external("String", str.get_type_axiom());
+      name_external("BigInt", big.get_type_axiom());
+      compacted_until = expression_context.checkpoint();
     }
-    mdb::Result<LexInfo, std::string> lex_code(BaseInfo input) {
+    mdb::Result<LexInfo, std::string> lex_code(BaseInfo input, PhaseStats& stats) {
+      PhaseMeasurement measure{stats, expression_context, "lex"};
       expression_parser::LexerInfo lexer_info {
         .symbol_map = {
           {"block", 0},
@@ -148,16 +203,19 @@ namespace expression::interactive {
           {"\\\\", 10},
           {".", 11},
           {"_", 12},
-          {",", 13}
+          {",", 13},
+          {"pragma", 14}
         }
       };
       auto ret = expression_parser::lex_string(input.source, lexer_info);
       if(auto* success = ret.get_if_value()) {
-        return LexInfo{
+        LexInfo info{
           input,
           archive(std::move(success->output)),
           archive(std::move(success->locator))
         };
+        stats.output_nodes = count_nodes(info.lexer_output);
+        return info;
       } else {
         auto const& error = ret.get_error();
         std::stringstream err;
@@ -165,14 +223,17 @@ namespace expression::interactive {
         return err.str();
       }
     }
-    mdb::Result<ReadInfo, std::string> read_code(LexInfo input) {
+    mdb::Result<ReadInfo, std::string> read_code(LexInfo input, PhaseStats& stats) {
+      PhaseMeasurement measure{stats, expression_context, "read"};
       auto ret = expression_parser::parse_lexed(input.lexer_output.root());
       if(auto* success = ret.get_if_value()) {
-        return ReadInfo{
+        ReadInfo info{
           std::move(input),
           archive(std::move(success->output)),
           archive(std::move(success->locator))
         };
+        stats.output_nodes = count_nodes(info.parser_output);
+        return info;
       } else {
         auto const& error = ret.get_error();
         std::stringstream err;
@@ -180,7 +241,8 @@ namespace expression::interactive {
         return err.str();
       }
     }
-    mdb::Result<ResolveInfo, std::string> resolve(ReadInfo input) {
+    mdb::Result<ResolveInfo, std::string> resolve(ReadInfo input, PhaseStats& stats) {
+      PhaseMeasurement measure{stats, expression_context, "resolve"};
       std::vector<TypedValue> embeds;
       std::unordered_map<std::string, std::uint64_t> names_to_embeds;
       auto resolved = expression_parser::resolve(expression_parser::resolved::ContextLambda {
@@ -218,17 +280,24 @@ namespace expression::interactive {
               auto ret = str(imported_type::StringHolder{literal});
               auto t = ret.get_data().data.type_of();
               embeds.push_back({std::move(ret), std::move(t)});
+            },
+            [&](expression_parser::literal::BigInteger const& literal) {
+              auto ret = big(*imported_type::BigInt::parse(literal.digits)); //the lexer only accepts digits
+              auto t = ret.get_data().data.type_of();
+              embeds.push_back({std::move(ret), std::move(t)});
             }
           }, literal);
           return ret;
         }
       }, input.parser_output.root());
       if(auto* resolve = resolved.get_if_value()) {
-        return ResolveInfo{
+        ResolveInfo info{
           std::move(input),
           std::move(embeds),
           archive(std::move(*resolve))
         };
+        stats.output_nodes = count_nodes(info.parser_resolved);
+        return info;
       } else {
         std::stringstream err_out;
         auto const& err = resolved.get_error();
@@ -243,21 +312,91 @@ namespace expression::interactive {
         return err_out.str();
       }
     }
-    EvaluateInfo evaluate(ResolveInfo input) {
+    bool bind_packed_nat(compiler::evaluate::PackedNat const& packed_nat) {
+      //zero and succ must be distinct, unbound axioms of types N and N -> N.
+      auto zero = expression_context.reduce(packed_nat.zero.value);
+      auto succ = expression_context.reduce(packed_nat.succ.value);
+      auto* zero_ext = zero.get_if_external();
+      auto* succ_ext = succ.get_if_external();
+      if(!zero_ext || !succ_ext || zero_ext->external_index == succ_ext->external_index) return false;
+      for(auto ext : {zero_ext->external_index, succ_ext->external_index}) {
+        auto const& info = expression_context.external_info[ext];
+        if(!info.is_axiom || !info.data_rules.empty()) return false;
+      }
+      for(auto const& bound : packed_nats) {
+        if(bound.get_zero() == zero_ext->external_index || bound.get_succ() == zero_ext->external_index) return false;
+      }
+      auto nat_type = expression_context.reduce(packed_nat.zero.type);
+      auto succ_type = expression_context.get_domain_and_codomain(packed_nat.succ.type);
+      if(!succ_type || expression_context.reduce(std::move(succ_type->domain)) != nat_type) return false;
+      if(expression_context.reduce(tree::Apply{std::move(succ_type->codomain), tree::Arg{0}}) != nat_type) return false;
+      if(spare_packed_nats.empty()) {
+        packed_nats.emplace_back(expression_context, std::move(nat_type), zero_ext->external_index, succ_ext->external_index);
+      } else {
+        packed_nats.push_back(std::move(spare_packed_nats.back()));
+        spare_packed_nats.pop_back();
+        packed_nats.back().bind(expression_context, std::move(nat_type), zero_ext->external_index, succ_ext->external_index);
+      }
+      return true;
+    }
+    EvaluateInfo evaluate(ResolveInfo input, CompileStats& stats) {
       auto rule_start = expression_context.rules.size();
+      std::optional<PhaseMeasurement> measure{std::in_place, stats.instructions, expression_context, "instructions"};
       auto instructions = compiler::instruction::make_instructions(input.parser_resolved.root());
       auto instruction_output = archive(std::move(instructions.output));
       auto instruction_locator = archive(std::move(instructions.locator));
+      stats.instructions.output_nodes = count_nodes(instruction_output);
+      measure.emplace(stats.evaluate, expression_context, "evaluate");
       auto eval_result = compiler::evaluate::evaluate_tree(instruction_output.root().get_program_root(), expression_context, [&](std::uint64_t embed_index) {
         return input.embeds.at(embed_index);
       });
+      stats.evaluate.casts = eval_result.casts.size() + eval_result.function_casts.size();
+      measure.emplace(stats.solve, expression_context, "solve");
       expression::solver::StandardSolverContext solver_context {
         .evaluation = expression_context
       };
-      expression::solver::Routine solve_routine{eval_result, expression_context, solver_context};
+      auto describe_source = [&](solver::SourceKind kind, std::uint64_t index) -> std::string { //the line of the cast or rule, for traces
+        auto line_of = [&](auto const& locator_index) {
+          auto position = input.parser_locator[locator_index].visit([&](auto const& o) { return o.position; });
+          auto text = expression_parser::position_of(position, input.lexer_locator);
+          return "line " + std::to_string(1 + std::count(input.source.data(), text.data(), '\n'));
+        };
+        if(kind == solver::SourceKind::cast_equation || kind == solver::SourceKind::cast_function_lhs || kind == solver::SourceKind::cast_function_rhs) {
+          auto var = kind == solver::SourceKind::cast_equation ? eval_result.casts[index].variable
+                   : kind == solver::SourceKind::cast_function_lhs ? eval_result.function_casts[index].function_variable
+                   : eval_result.function_casts[index].argument_variable;
+          if(!eval_result.variables.contains(var)) return "unknown position";
+          auto instruction = std::visit([&](auto const& reason) -> compiler::instruction::archive_index::PolymorphicKind {
+            return reason.index;
+          }, eval_result.variables.at(var));
+          return line_of(instruction_locator[instruction].visit([&](auto const& obj) { return obj.source.index; }));
+        } else {
+          return line_of(instruction_locator[eval_result.rule_explanations[index].index].source.index);
+        }
+      };
+      expression::solver::Routine solve_routine{eval_result, expression_context, solver_context, describe_source};
+      struct SolveCounts { //recorded when the phase ends, even by an exception, so budget failures keep partial counts
+        CompileStats& stats;
+        expression::solver::Routine& routine;
+        ~SolveCounts() {
+          stats.solve.equations = routine.get_equation_count();
+          stats.solver = routine.get_solver_stats();
+        }
+      };
+      std::optional<SolveCounts> solve_counts{std::in_place, stats, solve_routine};
       solve_routine.run();
       auto rule_end = expression_context.rules.size();
       auto hung_equations = solve_routine.get_errors();
+      std::vector<std::uint64_t> unbound_packed_nats;
+      if(hung_equations.failed_equations.empty() && hung_equations.unconstrainable_patterns.empty()) {
+        for(std::uint64_t i = 0; i < eval_result.packed_nats.size(); ++i) {
+          if(!bind_packed_nat(eval_result.packed_nats[i])) {
+            unbound_packed_nats.push_back(i);
+          }
+        }
+      }
+      solve_counts.reset();
+      measure.reset();
 
       return EvaluateInfo{
         std::move(input),
@@ -266,15 +405,16 @@ namespace expression::interactive {
         std::move(instruction_locator),
         rule_start,
         rule_end,
-        std::move(hung_equations)
+        std::move(hung_equations),
+        std::move(unbound_packed_nats)
       };
     }
-    mdb::Result<EvaluateInfo, std::string> full_compile(std::string_view str) {
+    mdb::Result<EvaluateInfo, std::string> full_compile(std::string_view str, CompileStats& stats) {
       return map(bind(
-        lex_code({str}),
-        [this](auto last) { return read_code(std::move(last)); },
-        [this](auto last) { return resolve(std::move(last)); }
-      ), [this](auto last) { return evaluate(std::move(last)); });
+        lex_code({str}, stats.lex),
+        [&](auto last) { return read_code(std::move(last), stats.read); },
+        [&](auto last) { return resolve(std::move(last), stats.resolve); }
+      ), [&](auto last) { return evaluate(std::move(last), stats); });
     }
     auto fancy_format(EvaluateInfo const& eval_info) {
       return expression::format::FormatContext{
@@ -308,7 +448,8 @@ namespace expression::interactive {
     }
 
     DeclarationInfo declare_or_axiom_check(std::string name, std::string_view expr, bool axiom) {
-      auto compile = full_compile(expr);
+      CompileStats stats;
+      auto compile = full_compile(expr, stats);
       if(auto* value = compile.get_if_value()) {
         auto ret = expression_context.reduce(std::move(value->evaluate_result.result.value));
         auto ret_type = expression_context.reduce(std::move(value->evaluate_result.result.type));
@@ -348,7 +489,72 @@ namespace expression::interactive {
       }
     }
     void debug_parse(std::string_view expr, std::ostream& output);
+    void debug_parse_unguarded(std::string_view expr, std::ostream& output);
     ParseResult parse(std::string_view expr);
+    BudgetFailure undo_compilation(Context::Checkpoint checkpoint, std::size_t packed_nat_count, BudgetExceeded const& exceeded) {
+      BudgetFailure ret{
+        .exceeded = exceeded,
+        .discarded_externals = expression_context.external_info.size() - checkpoint.external_count,
+        .discarded_rules = expression_context.rules.size() + expression_context.data_rules.size() - checkpoint.rule_count - checkpoint.data_rule_count
+      };
+      std::move(packed_nats.begin() + packed_nat_count, packed_nats.end(), std::back_inserter(spare_packed_nats));
+      packed_nats.erase(packed_nats.begin() + packed_nat_count, packed_nats.end());
+      expression_context.rollback(checkpoint);
+      return ret;
+    }
+    void compact() {
+      std::vector<tree::Expression*> roots;
+      for(auto& [name, value] : names_to_values) {
+        if(!value.value.holds_external()) { //keep declarations as themselves
+          value.value = expression_context.reduce(std::move(value.value));
+        }
+        value.type = expression_context.reduce(std::move(value.type));
+        roots.push_back(&value.value);
+        roots.push_back(&value.type);
+      }
+      auto compaction = expression_context.compact(compacted_until, roots);
+      std::unordered_map<std::uint64_t, std::string> new_names;
+      for(auto& [external, name] : externals_to_names) {
+        if(auto new_index = compaction.remap(external)) {
+          new_names.insert(std::make_pair(*new_index, std::move(name)));
+        }
+      }
+      externals_to_names = std::move(new_names);
+      compacted_until = expression_context.checkpoint();
+    }
+    void print_profile(std::ostream& output, std::size_t count) {
+      if(!expression_context.profile) return;
+      auto profile = *expression_context.profile; //formatting reduces, which would count towards the profile
+      expression::format::FormatContext format{
+        .expression_context = expression_context,
+        .force_expansion = [](std::uint64_t) { return false; },
+        .write_external = [&](std::ostream& o, std::uint64_t ext_index) {
+          if(externals_to_names.contains(ext_index)) {
+            o << externals_to_names.at(ext_index);
+          } else {
+            o << "ext_" << ext_index;
+          }
+        }
+      };
+      output << "Hottest rules:\n";
+      for(auto const& hot : profile.hottest_rules(count)) {
+        auto head = hot.is_data ? get_pattern_head(expression_context.data_rules[hot.rule].pattern) : get_pattern_head(expression_context.rules[hot.rule].pattern);
+        std::stringstream time; //keeps the formatting flags off output
+        time << std::fixed << std::setprecision(3) << std::chrono::duration<double, std::milli>(hot.counts.time).count() << "ms";
+        output << std::setw(12) << time.str() << std::setw(10) << hot.counts.firings << " fired  ";
+        if(hot.is_data) {
+          format.write_external(output, head);
+          output << " (native)";
+        } else {
+          output << format(trivial_replacement_for(expression_context.rules[hot.rule].pattern));
+        }
+        if(head < profile.heads.size()) {
+          auto const& head_counts = profile.heads[head];
+          output << "  [" << head_counts.lookups << " lookups, " << head_counts.failures() << " failed]";
+        }
+        output << "\n";
+      }
+    }
     bool deep_compare(tree::Expression lhs, tree::Expression rhs) {
       solver::StandardSolverContext context{expression_context};
       solver::Solver solver{context};
@@ -398,21 +604,39 @@ namespace expression::interactive {
   void Environment::debug_parse(std::string_view str, std::ostream& output) {
     return impl->debug_parse(str, output);
   }
+  void Environment::debug_parse(std::string_view str, std::ostream& output, Budget& budget) {
+    BudgetScope scope{impl->expression_context.budget, &budget};
+    return impl->debug_parse(str, output);
+  }
+  void Environment::compact() {
+    impl->compact();
+  }
+  void Environment::print_profile(std::ostream& output, std::size_t count) {
+    impl->print_profile(output, count);
+  }
+  CompileStats const& Environment::get_last_stats() const { return impl->last_stats; }
+  void Environment::set_print_stats(bool print_stats) { impl->print_stats = print_stats; }
   ParseResult Environment::parse(std::string_view str) {
     return impl->parse(str);
   }
+  ParseResult Environment::parse(std::string_view str, Budget& budget) {
+    BudgetScope scope{impl->expression_context.budget, &budget};
+    return impl->parse(str);
+  }
   void Environment::name_external(std::string name, std::uint64_t external) {
     return impl->name_external(std::move(name), external);
   }
   Context& Environment::context() { return impl->expression_context; }
   expression::data::SmallScalar<std::uint64_t> const& Environment::u64() const { return impl->u64; }
   expression::data::SmallScalar<imported_type::StringHolder> const& Environment::str() const { return impl->str; }
+  expression::data::SmallScalar<imported_type::BigInt> const& Environment::big() const { return impl->big; }
   bool Environment::deep_compare(tree::Expression lhs, tree::Expression rhs) const { return impl->deep_compare(std::move(lhs), std::move(rhs)); }
   bool Environment::deep_compare(TypedValue lhs, TypedValue rhs) const { return impl->deep_compare(std::move(lhs), std::move(rhs)); }
 
   struct ParseResult::Impl {
     Environment::Impl* environment;
-    std::variant<std::string, EvaluateInfo> data;
+    std::variant<std::string, EvaluateInfo, BudgetFailure> data;
+    CompileStats stats;
     bool has_result() const {
       return data.index() == 1;
     }
@@ -430,11 +654,19 @@ namespace expression::interactive {
         .type = environment->expression_context.reduce(get_result().type)
       };
     }
+    std::optional<BudgetExceeded> get_budget_exceeded() const {
+      if(auto* failure = std::get_if<2>(&data)) return failure->exceeded;
+      return std::nullopt;
+    }
     void print_errors_to(std::ostream& output) const {
       if(auto* error_str = std::get_if<0>(&data)) {
         output << *error_str;
         return;
       }
+      if(auto* failure = std::get_if<2>(&data)) {
+        print_budget_failure(output, *failure);
+        return;
+      }
       for(auto const& unconstrainable : info().error_info.unconstrainable_patterns) {
         auto const& reason = info().evaluate_result.rule_explanations[unconstrainable.rule_index];
         auto const& pos = info().instruction_locator[reason.index];
@@ -459,6 +691,15 @@ namespace expression::interactive {
         }
         output << "\n";
       }
+      for(auto packed_index : info().unbound_packed_nats) {
+        auto const& reason = info().evaluate_result.packed_nats[packed_index];
+        auto const& pos = info().instruction_locator[reason.index];
+        auto const& locator_pos = info().parser_locator[pos.source.index];
+        auto const& str_pos = locator_pos.visit([&](auto const& o) { return o.position; });
+        output << "Could not pack naturals; zero and succ must be distinct, unbound axioms of types N and N -> N: ";
+        output << format_info(expression_parser::position_of(str_pos, info().lexer_locator), info().source);
+        output << "\n";
+      }
       for(auto const& eq : info().error_info.failed_equations) {
         if(eq.failed) {
           output << red_string("False Equation: ");
@@ -504,6 +745,9 @@ namespace expression::interactive {
               [&](compiler::evaluate::variable_explanation::LetTypeCast const&) { return "While matching the let type against Type: "; },
               [&](compiler::evaluate::variable_explanation::LetCast const&) { return "While matching the declared type of the let with the expression type: "; },
               [&](compiler::evaluate::variable_explanation::ForAllTypeCast const&) { return "While matching the for all type against Type: "; },
+              [&](compiler::evaluate::variable_explanation::VectorTypeCast const&) { return "While matching the vector element type against Type: "; },
+              [&](compiler::evaluate::variable_explanation::VectorCast const&) { return "While matching the vector elements against the vector type: "; },
+              [&](compiler::evaluate::variable_explanation::VectorElementCast const&) { return "While matching a vector element against the vector type: "; },
               [&](auto const&) { return "For unknown reasons: "; }
             }, reason);
             auto const& index = std::visit([&](auto const& reason) -> compiler::instruction::archive_index::PolymorphicKind {
@@ -583,20 +827,38 @@ namespace expression::interactive {
     }
   };
   ParseResult Environment::Impl::parse(std::string_view expr) {
-    auto compile = full_compile(expr);
-    if(auto* value = compile.get_if_value()) {
-      return ParseResult{std::unique_ptr<ParseResult::Impl>{new ParseResult::Impl{
-        .environment = this,
-        .data = std::move(*value)
-      }}};
-    } else {
-      return ParseResult{std::unique_ptr<ParseResult::Impl>{new ParseResult::Impl{
-        .environment = this,
-        .data = std::move(compile.get_error())
-      }}};
+    auto checkpoint = expression_context.checkpoint();
+    auto packed_nat_count = packed_nats.size();
+    std::variant<std::string, EvaluateInfo, BudgetFailure> data;
+    last_stats = {};
+    try {
+      auto compile = full_compile(expr, last_stats);
+      if(auto* value = compile.get_if_value()) {
+        data = std::move(*value);
+      } else {
+        data = std::move(compile.get_error());
+      }
+    } catch(BudgetExceeded const& exceeded) {
+      data = undo_compilation(checkpoint, packed_nat_count, exceeded);
     }
+    return ParseResult{std::unique_ptr<ParseResult::Impl>{new ParseResult::Impl{
+      .environment = this,
+      .data = std::move(data),
+      .stats = last_stats
+    }}};
   }
   void Environment::Impl::debug_parse(std::string_view expr, std::ostream& output)  {
+    //Simplifying and printing the result reduces too, so may also exhaust a budget.
+    auto checkpoint = expression_context.checkpoint();
+    auto packed_nat_count = packed_nats.size();
+    try {
+      debug_parse_unguarded(expr, output);
+    } catch(BudgetExceeded const& exceeded) {
+      print_budget_failure(output, undo_compilation(checkpoint, packed_nat_count, exceeded));
+    }
+    if(print_stats) output << last_stats;
+  }
+  void Environment::Impl::debug_parse_unguarded(std::string_view expr, std::ostream& output)  {
     auto result = parse(expr);
     if(result.has_result()) {
       auto value = std::get_if<1>(&result.impl->data);
@@ -655,8 +917,11 @@ namespace expression::interactive {
         }
         output << "\n";
       }*/
-      for(auto i = value->rule_begin; i < value->rule_end; ++i) {
-        expression_context.replace_rule(i, rule::simplify_rule(expression_context.rules[i], expression_context));
+      {
+        PhaseMeasurement measure{last_stats.simplify, expression_context, "simplify"};
+        for(auto i = value->rule_begin; i < value->rule_end; ++i) {
+          expression_context.replace_rule(i, rule::simplify_rule(expression_context.rules[i], expression_context));
+        }
       }
       /*{
         std::vector<expression::Rule> new_rules;
@@ -682,7 +947,11 @@ namespace expression::interactive {
       //output << "Spine type: " << raw_format(expression_context.reduce(result.get_result().type)) << "\n";
 
       //output << "Final: " << fancy(result.get_result().value) << " of type " << fancy(result.get_result().type) << "\n";
-      output << deep(result.get_result().value) << " of type " << deep(result.get_result().type) << "\n";
+      {
+        PhaseMeasurement measure{last_stats.print, expression_context, "print"};
+        output << deep(result.get_result().value) << " of type " << deep(result.get_result().type) << "\n";
+      }
+      result.impl->stats = last_stats;
       result.impl->put_values_into_context();
     } else {
       result.print_errors_to(output);
@@ -696,7 +965,30 @@ namespace expression::interactive {
   bool ParseResult::is_fully_solved() const { return impl->is_fully_solved(); }
   TypedValue const& ParseResult::get_result() const { return impl->get_result(); }
   TypedValue ParseResult::get_reduced_result() const { return impl->get_reduced_result(); }
+  std::optional<BudgetExceeded> ParseResult::get_budget_exceeded() const { return impl->get_budget_exceeded(); }
+  CompileStats const& ParseResult::get_stats() const { return impl->stats; }
   void ParseResult::print_errors_to(std::ostream& output) const{ return impl->print_errors_to(output); }
+  std::ostream& operator<<(std::ostream& output, CompileStats const& stats) {
+    std::pair<char const*, PhaseStats const*> phases[] = {
+      {"lex", &stats.lex},
+      {"read", &stats.read},
+      {"resolve", &stats.resolve},
+      {"instructions", &stats.instructions},
+      {"evaluate", &stats.evaluate},
+      {"solve", &stats.solve},
+      {"simplify", &stats.simplify},
+      {"print", &stats.print}
+    };
+    output << std::left << std::setw(14) << "Phase" << std::right << std::setw(12) << "Time" << std::setw(12) << "Allocated" << std::setw(10) << "Output"
+           << std::setw(11) << "Externals" << std::setw(8) << "Rules" << std::setw(8) << "Casts" << std::setw(11) << "Equations" << "\n";
+    for(auto const& [name, phase] : phases) {
+      std::stringstream time; //keeps the formatting flags off output
+      time << std::fixed << std::setprecision(3) << std::chrono::duration<double, std::milli>(phase->time).count() << "ms";
+      output << std::left << std::setw(14) << name << std::right << std::setw(12) << time.str() << std::setw(12) << phase->node_allocations << std::setw(10) << phase->output_nodes
+             << std::setw(11) << phase->externals_created << std::setw(8) << phase->rules_created << std::setw(8) << phase->casts << std::setw(11) << phase->equations << "\n";
+    }
+    return output << stats.solver;
+  }
 }
 /*
 Final: \$0.\$1.\$2.\$3.iterate $0 $1 $2 $3 of type
@@ -3,9 +3,33 @@
 
 #include "evaluation_context.hpp"
 #include "data_helper.hpp"
+#include "solver.hpp"
 #include "../ImportedTypes/string_holder.hpp"
+#include "../ImportedTypes/big_int.hpp"
+#include <chrono>
 
 namespace expression::interactive {
+  struct PhaseStats {
+    std::chrono::steady_clock::duration time{};
+    std::uint64_t node_allocations = 0; //expression nodes allocated
+    std::uint64_t output_nodes = 0; //in the tree the phase produced, if it produces one
+    std::uint64_t externals_created = 0;
+    std::uint64_t rules_created = 0; //including data rules
+    std::uint64_t casts = 0; //requested by the evaluator
+    std::uint64_t equations = 0; //created by the solver, including derived equations
+  };
+  struct CompileStats { //phases which did not run are left empty
+    PhaseStats lex;
+    PhaseStats read;
+    PhaseStats resolve;
+    PhaseStats instructions;
+    PhaseStats evaluate;
+    PhaseStats solve;
+    PhaseStats simplify; //only run by debug_parse
+    PhaseStats print; //reducing and printing the result; only run by debug_parse
+    solver::SolverStats solver; //of the solve phase
+  };
+  std::ostream& operator<<(std::ostream&, CompileStats const&);
   class Environment;
   class ParseResult {
     struct Impl;
@@ -20,6 +44,8 @@ namespace expression::interactive {
     bool is_fully_solved() const;
     TypedValue const& get_result() const; //only call after checking it has a result!
     TypedValue get_reduced_result() const;
+    std::optional<BudgetExceeded> get_budget_exceeded() const; //set if compiling ran out of budget and was undone
+    CompileStats const& get_stats() const;
     void print_errors_to(std::ostream&) const;
     void print_value(std::ostream&, tree::Expression val) const;
   };
@@ -44,11 +70,34 @@ namespace expression::interactive {
     void name_external(std::string name, std::uint64_t external);
 
     void debug_parse(std::string_view, std::ostream& output = std::cout);
+    void debug_parse(std::string_view, std::ostream& output, Budget&);
     ParseResult parse(std::string_view);
+    /*
+      As above, but charging the compilation to the budget. If it runs out,
+      everything the compilation created is discarded and the result reports
+      the exhausted budget instead of a value.
+    */
+    ParseResult parse(std::string_view, Budget&);
+    /*
+      Discards the externals and rules created since the last compaction which
+      are no longer reachable from any name, renumbering the rest. Indices of
+      externals created since then and any outstanding ParseResult are
+      invalidated.
+    */
+    void compact();
+    /*
+      Writes the rules which took the most time since profiling was turned on
+      in the context, with the lookups of their heads. Writes nothing unless
+      the context is profiling.
+    */
+    void print_profile(std::ostream& output, std::size_t count);
+    CompileStats const& get_last_stats() const; //of the last call to parse or debug_parse
+    void set_print_stats(bool); //if set, debug_parse writes its CompileStats, solver counts included, after the result
 
     Context& context();
     expression::data::SmallScalar<std::uint64_t> const& u64() const;
     expression::data::SmallScalar<imported_type::StringHolder> const& str() const;
+    expression::data::SmallScalar<imported_type::BigInt> const& big() const;
 
     bool deep_compare(tree::Expression, tree::Expression) const;
     bool deep_compare(TypedValue, TypedValue) const;
@@ -0,0 +1,55 @@
+#include "reduction_cache.hpp"
+
+namespace expression {
+  void ReductionCache::StuckHeads::add(std::uint64_t head) {
+    if(overflow) return;
+    for(std::uint8_t i = 0; i < count; ++i) {
+      if(heads[i] == head) return;
+    }
+    if(count == capacity) {
+      overflow = true;
+    } else {
+      heads[count++] = head;
+    }
+  }
+  void ReductionCache::StuckHeads::merge(StuckHeads const& other) {
+    if(overflow) return;
+    if(other.overflow) {
+      overflow = true;
+      return;
+    }
+    for(std::uint8_t i = 0; i < other.count; ++i) {
+      add(other.heads[i]);
+    }
+  }
+  ReductionCache::ReductionCache(std::size_t generation_capacity):generation_capacity(generation_capacity) {}
+  void ReductionCache::rotate_if_full() {
+    if(young.size() >= generation_capacity) {
+      old = std::move(young);
+      young.clear();
+    }
+  }
+  auto ReductionCache::find(tree::Expression const& key) -> Entry const* {
+    if(auto it = young.find(key); it != young.end()) {
+      return &it->second;
+    }
+    if(auto it = old.find(key); it != old.end()) {
+      auto node = old.extract(it); //node handles keep the entry's address stable
+      rotate_if_full();
+      return &young.insert(std::move(node)).position->second;
+    }
+    return nullptr;
+  }
+  void ReductionCache::insert(tree::Expression key, Entry entry) {
+    if(auto it = young.find(key); it != young.end()) {
+      it->second = std::move(entry);
+      return;
+    }
+    rotate_if_full();
+    young.insert_or_assign(std::move(key), std::move(entry));
+  }
+  void ReductionCache::clear() {
+    young.clear();
+    old.clear();
+  }
+}
@@ -0,0 +1,61 @@
+#ifndef REDUCTION_CACHE_HPP
+#define REDUCTION_CACHE_HPP
+
+#include "expression_tree.hpp"
+#include <array>
+#include <unordered_map>
+
+namespace expression {
+  /*
+    Remembers the normal forms found by previous reductions, keyed by the
+    identity (not the structure) of the reduced node. Each entry records the
+    non-axiomatic externals which appear stuck in its normal form, along with
+    the rule epoch at which it was recorded - so it remains valid until one of
+    those externals gains a rule. Entries that have gone stale are still
+    reducts of their key and may be used as a starting point.
+
+    The cache is bounded by keeping two generations: once the young generation
+    fills, the old one is dropped and the young one takes its place. Hits in
+    the old generation are promoted back into the young one.
+  */
+  class ReductionCache {
+  public:
+    struct StuckHeads {
+      static constexpr std::size_t capacity = 4;
+      std::array<std::uint64_t, capacity> heads;
+      std::uint8_t count = 0;
+      bool overflow = false; //if set, too many heads to track; valid only while no rules are added.
+      void add(std::uint64_t head);
+      void merge(StuckHeads const&);
+    };
+    struct Entry {
+      tree::Expression normal_form;
+      std::uint64_t epoch;
+      StuckHeads stuck_heads;
+    };
+    static constexpr std::size_t default_generation_capacity = 1 << 12;
+    explicit ReductionCache(std::size_t generation_capacity = default_generation_capacity);
+    Entry const* find(tree::Expression const&);
+    void insert(tree::Expression key, Entry entry);
+    void clear();
+    std::size_t size() const { return young.size() + old.size(); }
+  private:
+    struct IdentityHash {
+      std::size_t operator()(tree::Expression const& expr) const noexcept {
+        return std::hash<void const*>{}(expr.data());
+      }
+    };
+    struct IdentityEqual {
+      bool operator()(tree::Expression const& lhs, tree::Expression const& rhs) const noexcept {
+        return lhs.data() == rhs.data();
+      }
+    };
+    using Map = std::unordered_map<tree::Expression, Entry, IdentityHash, IdentityEqual>;
+    void rotate_if_full();
+    std::size_t generation_capacity;
+    Map young;
+    Map old;
+  };
+}
+
+#endif
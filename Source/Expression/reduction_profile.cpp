@@ -0,0 +1,25 @@
+#include "reduction_profile.hpp"
+#include <algorithm>
+
+namespace expression {
+  auto ReductionProfile::hottest_rules(std::size_t count) const -> std::vector<HotRule> {
+    std::vector<HotRule> ret;
+    for(std::uint64_t i = 0; i < rules.size(); ++i) {
+      if(rules[i].firings > 0) ret.push_back({false, i, rules[i]});
+    }
+    for(std::uint64_t i = 0; i < data_rules.size(); ++i) {
+      if(data_rules[i].firings > 0) ret.push_back({true, i, data_rules[i]});
+    }
+    auto hotter = [](HotRule const& lhs, HotRule const& rhs) {
+      if(lhs.counts.time != rhs.counts.time) return lhs.counts.time > rhs.counts.time;
+      return lhs.counts.firings > rhs.counts.firings;
+    };
+    if(ret.size() > count) {
+      std::partial_sort(ret.begin(), ret.begin() + count, ret.end(), hotter);
+      ret.resize(count);
+    } else {
+      std::sort(ret.begin(), ret.end(), hotter);
+    }
+    return ret;
+  }
+}
@@ -0,0 +1,62 @@
+#ifndef REDUCTION_PROFILE_HPP
+#define REDUCTION_PROFILE_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace expression {
+  /*
+    Counts of the work done by reductions, collected while profiling is on.
+
+    The rules of a head are matched together by its rule index rather than
+    tried one at a time, so a lookup either fires the rule it finds or fails
+    as a whole: lookups and failures are counted by head, firings by both
+    head and rule. Time covers matching and building the replacement.
+  */
+  struct ReductionProfile {
+    using Clock = std::chrono::steady_clock;
+    struct HeadCounts {
+      std::uint64_t lookups = 0;
+      std::uint64_t firings = 0;
+      Clock::duration time{};
+      std::uint64_t failures() const { return lookups - firings; }
+    };
+    struct RuleCounts {
+      std::uint64_t firings = 0;
+      Clock::duration time{};
+    };
+    std::vector<HeadCounts> heads; //indexed by external; grown as needed
+    std::vector<RuleCounts> rules; //parallel to Context::rules; grown as needed
+    std::vector<RuleCounts> data_rules; //parallel to Context::data_rules; grown as needed
+
+    void record_firing(std::uint64_t head, bool is_data, std::uint64_t rule, Clock::duration time) {
+      auto& head_counts = at(heads, head);
+      ++head_counts.lookups;
+      ++head_counts.firings;
+      head_counts.time += time;
+      auto& rule_counts = at(is_data ? data_rules : rules, rule);
+      ++rule_counts.firings;
+      rule_counts.time += time;
+    }
+    void record_failure(std::uint64_t head, Clock::duration time) {
+      auto& head_counts = at(heads, head);
+      ++head_counts.lookups;
+      head_counts.time += time;
+    }
+    struct HotRule {
+      bool is_data;
+      std::uint64_t rule;
+      RuleCounts counts;
+    };
+    std::vector<HotRule> hottest_rules(std::size_t count) const; //by time spent, most first
+  private:
+    template<class T>
+    static T& at(std::vector<T>& counts, std::uint64_t index) {
+      if(index >= counts.size()) counts.resize(index + 1);
+      return counts[index];
+    }
+  };
+}
+
+#endif
@@ -0,0 +1,110 @@
+#include "replacement_program.hpp"
+#include <unordered_map>
+
+namespace expression {
+  ReplacementProgram::ReplacementProgram(tree::Expression const& replacement) {
+    struct Detail {
+      ReplacementProgram& program;
+      std::unordered_map<std::uint64_t, std::size_t> last_use; //capture -> instruction
+      void push_constant(tree::Expression const& expr) {
+        program.instructions.push_back({Opcode::push_constant, std::uint32_t(program.constants.size())});
+        program.constants.push_back(expr);
+      }
+      bool compile(tree::Expression const& expr) { //returns true if expr was pushed as a constant
+        return expr.visit(mdb::overloaded{
+          [&](tree::Apply const& apply) {
+            auto instruction_count = program.instructions.size();
+            auto constant_count = program.constants.size();
+            bool lhs_closed = compile(apply.lhs);
+            bool rhs_closed = compile(apply.rhs);
+            if(lhs_closed && rhs_closed) {
+              program.instructions.erase(program.instructions.begin() + instruction_count, program.instructions.end());
+              program.constants.erase(program.constants.begin() + constant_count, program.constants.end());
+              push_constant(expr);
+              return true;
+            }
+            program.instructions.push_back({Opcode::apply, 0});
+            return false;
+          },
+          [&](tree::External const&) {
+            push_constant(expr);
+            return true;
+          },
+          [&](tree::Arg const& arg) {
+            last_use.insert_or_assign(arg.arg_index, program.instructions.size());
+            program.instructions.push_back({Opcode::copy_capture, std::uint32_t(arg.arg_index)});
+            program.captures_needed = std::max<std::uint64_t>(program.captures_needed, arg.arg_index + 1);
+            return false;
+          },
+          [&](tree::Data const& data) {
+            //Data is always rebuilt: natives may move out of the storage of their arguments.
+            data.data.visit_children([&](tree::Expression const& child) {
+              visit_args(child);
+            });
+            program.instructions.push_back({Opcode::substitute_data, std::uint32_t(program.constants.size())});
+            program.constants.push_back(expr);
+            return false;
+          }
+        });
+      }
+      bool visit_args(tree::Expression const& expr) { //returns true if expr mentions a capture
+        return expr.visit(mdb::overloaded{
+          [&](tree::Apply const& apply) {
+            bool lhs = visit_args(apply.lhs);
+            bool rhs = visit_args(apply.rhs);
+            return lhs || rhs;
+          },
+          [&](tree::External const&) {
+            return false;
+          },
+          [&](tree::Arg const& arg) {
+            last_use.erase(arg.arg_index); //data substitution needs the capture in place
+            program.captures_needed = std::max<std::uint64_t>(program.captures_needed, arg.arg_index + 1);
+            return true;
+          },
+          [&](tree::Data const& data) {
+            bool ret = false;
+            data.data.visit_children([&](tree::Expression const& child) {
+              if(visit_args(child)) ret = true;
+            });
+            return ret;
+          }
+        });
+      }
+    };
+    Detail detail{*this};
+    detail.compile(replacement);
+    for(auto const& [capture, position] : detail.last_use) {
+      instructions[position].opcode = Opcode::move_capture;
+    }
+  }
+  tree::Expression ReplacementProgram::instantiate(std::vector<tree::Expression>& captures, std::vector<tree::Expression>& stack) const {
+    if(captures.size() < captures_needed) throw NotEnoughArguments{};
+    auto base = stack.size();
+    for(auto const& instruction : instructions) {
+      switch(instruction.opcode) {
+        case Opcode::copy_capture:
+          stack.push_back(captures[instruction.index]);
+          break;
+        case Opcode::move_capture:
+          stack.push_back(std::move(captures[instruction.index]));
+          break;
+        case Opcode::push_constant:
+          stack.push_back(constants[instruction.index]);
+          break;
+        case Opcode::substitute_data:
+          stack.push_back(constants[instruction.index].get_data().data.substitute(captures));
+          break;
+        case Opcode::apply: {
+          auto rhs = std::move(stack.back());
+          stack.pop_back();
+          stack.back() = tree::Apply{std::move(stack.back()), std::move(rhs)};
+          break;
+        }
+      }
+    }
+    auto ret = std::move(stack.back());
+    stack.erase(stack.begin() + base, stack.end());
+    return ret;
+  }
+}
@@ -0,0 +1,37 @@
+#ifndef REPLACEMENT_PROGRAM_HPP
+#define REPLACEMENT_PROGRAM_HPP
+
+#include "expression_tree.hpp"
+
+namespace expression {
+  /*
+    A rule's replacement compiled for instantiation. The tree is flattened in
+    postorder into instructions for a small stack machine: push a capture,
+    push a constant, substitute into a data constant, or apply the top two
+    entries. Subtrees mentioning no captures become single constants, and so
+    are shared with the replacement rather than rebuilt.
+  */
+  class ReplacementProgram {
+  public:
+    explicit ReplacementProgram(tree::Expression const& replacement);
+    //Equivalent to substitute_into_replacement(captures, replacement). The last use of each capture moves it.
+    tree::Expression instantiate(std::vector<tree::Expression>& captures, std::vector<tree::Expression>& stack) const;
+  private:
+    enum class Opcode : std::uint8_t {
+      copy_capture,
+      move_capture,
+      push_constant,
+      substitute_data,
+      apply
+    };
+    struct Instruction {
+      Opcode opcode;
+      std::uint32_t index; //of the capture or constant
+    };
+    std::vector<Instruction> instructions;
+    std::vector<tree::Expression> constants;
+    std::uint64_t captures_needed = 0;
+  };
+}
+
+#endif
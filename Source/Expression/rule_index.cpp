@@ -0,0 +1,114 @@
+#include "rule_index.hpp"
+#include <algorithm>
+
+namespace expression {
+  namespace {
+    template<class PatternType, class Emit>
+    void flatten_arguments(PatternType const& pattern, Emit&& emit) {
+      //Emits the preorder symbols of each argument of the pattern, in order.
+      std::vector<PatternType const*> args;
+      PatternType const* head = &pattern;
+      while(auto* apply = head->get_if_apply()) {
+        args.push_back(&apply->rhs);
+        head = &apply->lhs;
+      }
+      for(auto it = args.rbegin(); it != args.rend(); ++it) {
+        emit(**it);
+      }
+    }
+  }
+  void RuleIndex::add(pattern::Pattern const& pattern, Candidate candidate) {
+    std::vector<Symbol> symbols;
+    struct Detail {
+      std::vector<Symbol>& symbols;
+      void emit(pattern::Pattern const& pattern) {
+        pattern.visit(mdb::overloaded{
+          [&](pattern::Apply const& apply) {
+            symbols.push_back({SymbolKind::apply});
+            emit(apply.lhs);
+            emit(apply.rhs);
+          },
+          [&](pattern::Fixed const& fixed) {
+            symbols.push_back({SymbolKind::fixed, fixed.external_index});
+          },
+          [&](pattern::Wildcard const&) {
+            symbols.push_back({SymbolKind::wildcard});
+          }
+        });
+      }
+    };
+    Detail detail{symbols};
+    std::size_t position = 0;
+    flatten_arguments(pattern, [&](pattern::Pattern const& arg) {
+      note_argument(position++, !arg.holds_wildcard());
+      detail.emit(arg);
+    });
+    add_symbols(symbols, candidate);
+  }
+  void RuleIndex::add(data_pattern::Pattern const& pattern, Candidate candidate) {
+    std::vector<Symbol> symbols;
+    struct Detail {
+      std::vector<Symbol>& symbols;
+      void emit(data_pattern::Pattern const& pattern) {
+        pattern.visit(mdb::overloaded{
+          [&](data_pattern::Apply const& apply) {
+            symbols.push_back({SymbolKind::apply});
+            emit(apply.lhs);
+            emit(apply.rhs);
+          },
+          [&](data_pattern::Fixed const& fixed) {
+            symbols.push_back({SymbolKind::fixed, fixed.external_index});
+          },
+          [&](data_pattern::Wildcard const&) {
+            symbols.push_back({SymbolKind::wildcard});
+          },
+          [&](data_pattern::Data const& data) {
+            symbols.push_back({SymbolKind::data, data.type_index});
+          }
+        });
+      }
+    };
+    Detail detail{symbols};
+    std::size_t position = 0;
+    flatten_arguments(pattern, [&](data_pattern::Pattern const& arg) {
+      note_argument(position++, true); //data rules are opaque callbacks, so every capture is given to them normalized
+      detail.emit(arg);
+    });
+    add_symbols(symbols, candidate);
+  }
+  void RuleIndex::add_symbols(std::vector<Symbol> const& symbols, Candidate candidate) {
+    if(nodes.empty()) nodes.emplace_back();
+    auto get_or_create = [&](std::size_t& child) {
+      if(child != none) return child;
+      auto index = nodes.size();
+      child = index; //before emplace_back invalidates the reference
+      nodes.emplace_back();
+      return index;
+    };
+    auto get_or_create_keyed = [&](std::size_t node, bool data, std::uint64_t key) {
+      auto& children = data ? nodes[node].data_children : nodes[node].fixed_children;
+      auto child = find_child(children, key);
+      if(child != none) return child;
+      child = nodes.size();
+      children.emplace_back(key, child); //before emplace_back invalidates the reference
+      nodes.emplace_back();
+      return child;
+    };
+    std::size_t position = 0;
+    nodes[0].min_rank = std::min(nodes[0].min_rank, candidate.rank);
+    for(auto const& symbol : symbols) {
+      switch(symbol.kind) {
+        case SymbolKind::apply: position = get_or_create(nodes[position].apply_child); break;
+        case SymbolKind::wildcard: position = get_or_create(nodes[position].wildcard_child); break;
+        case SymbolKind::fixed: position = get_or_create_keyed(position, false, symbol.index); break;
+        case SymbolKind::data: position = get_or_create_keyed(position, true, symbol.index); break;
+      }
+      nodes[position].min_rank = std::min(nodes[position].min_rank, candidate.rank);
+    }
+    auto& accepting = nodes[position].accepting;
+    auto it = std::upper_bound(accepting.begin(), accepting.end(), candidate.rank, [](std::uint64_t rank, Candidate const& other) {
+      return rank < other.rank;
+    });
+    accepting.insert(it, candidate);
+  }
+}
@@ -0,0 +1,173 @@
+#ifndef RULE_INDEX_HPP
+#define RULE_INDEX_HPP
+
+#include "expression_tree.hpp"
+#include <deque>
+#include <limits>
+#include <optional>
+#include <span>
+
+namespace expression {
+  /*
+    A discrimination tree over the rules sharing a head. Each rule's arguments
+    are flattened into their preorder sequence of symbols (application, fixed
+    external, data type, or wildcard), and the sequences of all rules are
+    merged into a trie. Matching walks the trie alongside the arguments of a
+    term, following both the specific edge and the wildcard edge at each step.
+
+    Rules are ranked by priority - every ordinary rule before every data rule,
+    each in order of addition - and the earliest-ranked match is returned,
+    matching the order in which rules used to be tried one after another.
+    Subtrees whose best rank cannot improve on the best match so far are
+    skipped.
+  */
+  class RuleIndex {
+  public:
+    struct Candidate {
+      std::uint64_t rank;
+      bool is_data;
+      std::uint64_t rule_index; //index into Context::rules or Context::data_rules
+      std::uint64_t arg_count;
+    };
+    /*
+      Scratch space for find, reused between calls so that matching does not
+      allocate once it has warmed up. After a successful find, captures holds
+      the captures of the match.
+    */
+    struct MatchBuffer {
+      std::vector<tree::Expression> captures;
+      std::vector<tree::Expression const*> pending; //subterms left in the current argument; next at back
+      std::vector<tree::Expression const*> path_captures; //captured along the current path
+      std::deque<tree::Expression> peeled; //data peeled into constructor applications; stable while pointed into
+    };
+    static std::uint64_t rank_of(bool is_data, std::uint64_t position) {
+      return (std::uint64_t(is_data) << 63) | position;
+    }
+    void add(pattern::Pattern const&, Candidate);
+    void add(data_pattern::Pattern const&, Candidate);
+    //Whether some pattern looks at the (arg+1)th argument rather than capturing it whole.
+    bool inspects(std::size_t arg) const { return arg < inspected_args.size() && inspected_args[arg]; }
+    /*
+      args[i] is the (i+1)th argument of the term. Returns the best-ranked rule
+      for which accept(candidate) is true, leaving its captures in the buffer.
+      Captures are collected in the same traversal that matches the rule.
+    */
+    template<class Accept>
+    std::optional<Candidate> find(std::span<tree::Expression const* const> args, MatchBuffer& buffer, Accept&& accept) const;
+  private:
+    static constexpr std::size_t none = -1;
+    struct Node {
+      std::uint64_t min_rank = std::numeric_limits<std::uint64_t>::max(); //of every candidate at or below this node
+      std::vector<Candidate> accepting; //sorted by rank
+      std::size_t apply_child = none;
+      std::size_t wildcard_child = none;
+      std::vector<std::pair<std::uint64_t, std::size_t>> fixed_children;
+      std::vector<std::pair<std::uint64_t, std::size_t>> data_children;
+      bool has_children() const {
+        return apply_child != none || wildcard_child != none || !fixed_children.empty() || !data_children.empty();
+      }
+    };
+    enum class SymbolKind { apply, fixed, data, wildcard };
+    struct Symbol {
+      SymbolKind kind;
+      std::uint64_t index = 0;
+    };
+    void add_symbols(std::vector<Symbol> const&, Candidate);
+    void note_argument(std::size_t arg, bool inspected) {
+      if(inspected_args.size() <= arg) inspected_args.resize(arg + 1);
+      if(inspected) inspected_args[arg] = true;
+    }
+    static std::size_t find_child(std::vector<std::pair<std::uint64_t, std::size_t>> const& children, std::uint64_t index) {
+      for(auto const& [key, child] : children) {
+        if(key == index) return child;
+      }
+      return none;
+    }
+    std::vector<Node> nodes;
+    std::vector<bool> inspected_args; //by argument position
+  };
+  template<class Accept>
+  std::optional<RuleIndex::Candidate> RuleIndex::find(std::span<tree::Expression const* const> args, MatchBuffer& buffer, Accept&& accept) const {
+    if(nodes.empty()) return std::nullopt;
+    struct Detail {
+      RuleIndex const& index;
+      std::span<tree::Expression const* const> args;
+      MatchBuffer& buffer;
+      Accept& accept;
+      std::optional<Candidate> best;
+      std::uint64_t best_rank = std::numeric_limits<std::uint64_t>::max();
+      void search(std::size_t node_index, std::size_t args_used) {
+        auto const& node = index.nodes[node_index];
+        if(node.min_rank >= best_rank) return;
+        auto& pending = buffer.pending;
+        auto& path_captures = buffer.path_captures;
+        if(pending.empty()) { //at the boundary between arguments
+          for(auto const& candidate : node.accepting) {
+            if(candidate.rank >= best_rank) break;
+            if(accept(candidate)) {
+              best = candidate;
+              best_rank = candidate.rank;
+              buffer.captures.clear();
+              for(auto const* capture : path_captures) {
+                buffer.captures.push_back(*capture);
+              }
+              break;
+            }
+          }
+          if(args_used == args.size() || !node.has_children()) return;
+          pending.push_back(args[args_used]);
+          search(node_index, args_used + 1);
+          pending.pop_back();
+          return;
+        }
+        auto const* term = pending.back();
+        pending.pop_back();
+        if(auto* apply = term->get_if_apply()) {
+          if(node.apply_child != none) {
+            pending.push_back(&apply->rhs);
+            pending.push_back(&apply->lhs);
+            search(node.apply_child, args_used);
+            pending.pop_back();
+            pending.pop_back();
+          }
+        } else if(auto* external = term->get_if_external()) {
+          auto child = find_child(node.fixed_children, external->external_index);
+          if(child != none) {
+            search(child, args_used);
+          }
+        } else if(auto* data = term->get_if_data()) {
+          auto child = find_child(node.data_children, data->data.get_type_index());
+          if(child != none) {
+            path_captures.push_back(term);
+            search(child, args_used);
+            path_captures.pop_back();
+          }
+          if(node.apply_child != none) {
+            if(auto peeled = data->data.peel()) { //packed data may still match constructor patterns
+              auto const& apply = buffer.peeled.emplace_back(std::move(*peeled)).get_apply();
+              pending.push_back(&apply.rhs);
+              pending.push_back(&apply.lhs);
+              search(node.apply_child, args_used);
+              pending.pop_back();
+              pending.pop_back();
+            }
+          }
+        }
+        if(node.wildcard_child != none) {
+          path_captures.push_back(term);
+          search(node.wildcard_child, args_used);
+          path_captures.pop_back();
+        }
+        pending.push_back(term);
+      }
+    };
+    buffer.pending.clear();
+    buffer.path_captures.clear();
+    buffer.peeled.clear();
+    Detail detail{*this, args, buffer, accept};
+    detail.search(0, 0);
+    return detail.best;
+  }
+}
+
+#endif
@@ -32,23 +32,11 @@ namespace expression::rule {
       pattern::match::Any{},
       pattern::match::Wildcard{}
     };*/
-    bool needs_more_arguments(tree::Expression const& input, Context& context) {
-      for(auto const& rule : context.rules) {
-        pattern::Pattern const* pat = &rule.pattern;
-        while(pattern::Apply const* app = pat->get_if_apply()) {
-          if(term_matches(input, app->lhs)) {
-            return true;
-          }
-          pat = &app->lhs;
-        }
-      }
-      return false;
-    }
   }
   Rule simplify_rule(Rule rule, Context& context) {
   KEEP_SIMPLIFYING:
     rule.replacement = context.reduce(rule.replacement);
-    if(needs_more_arguments(rule.replacement, context)) {
+    if(context.needs_more_arguments(rule.replacement)) {
       auto next_arg = count_wildcards(rule.pattern);
       rule.pattern = pattern::Apply{std::move(rule.pattern), pattern::Wildcard{}};
       rule.replacement = tree::Apply{std::move(rule.replacement), tree::Arg{next_arg}};
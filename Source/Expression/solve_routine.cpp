@@ -63,6 +63,9 @@ namespace expression::solver {
               return expression::pattern::Wildcard{};
             },
             [&](expression::tree::Data const& data) -> std::optional<expression::pattern::Pattern> {
+              if(auto peeled = data.data.peel()) { //packed data matches as the application it stands for
+                return convert_to_pattern(*peeled, spine);
+              }
               return std::nullopt;
             }
           });
@@ -95,10 +98,22 @@ namespace expression::solver {
       tree::Expression pattern;
     };
   }
+  char const* name_of(SourceKind kind) {
+    switch(kind) {
+      case SourceKind::cast_equation: return "cast_equation";
+      case SourceKind::cast_function_lhs: return "cast_function_lhs";
+      case SourceKind::cast_function_rhs: return "cast_function_rhs";
+      case SourceKind::rule_equation: return "rule_equation";
+      case SourceKind::rule_skeleton: return "rule_skeleton";
+      case SourceKind::rule_skeleton_verify: return "rule_skeleton_verify";
+    }
+    return "unknown";
+  }
   struct Routine::Impl {
     compiler::evaluate::EvaluateResult& input;
     expression::Context& expression_context;
     StandardSolverContext solver_context;
+    SourceDescriber describe_source;
     Solver solver;
     std::vector<PatternConstrainer> waiting_constrained_patterns;
     std::vector<HungRoutineEquation> hung_equations;
@@ -119,6 +134,13 @@ namespace expression::solver {
       }
       return true;
     }
+    std::string trace_label(SourceKind source_kind, std::uint64_t source_index) {
+      if(!expression_context.tracer) return {};
+      std::string ret = name_of(source_kind);
+      ret += " #" + std::to_string(source_index);
+      if(describe_source) ret += " at " + describe_source(source_kind, source_index);
+      return ret;
+    }
     auto report_if_failure(SourceKind source_kind, std::uint64_t source_index) {
       return [this, source_kind, source_index](std::optional<SolveError> error) mutable {
         if(error) {
@@ -136,11 +158,14 @@ namespace expression::solver {
     }
     auto rule_routine(std::uint64_t index, compiler::evaluate::Rule rule) {
       solver.solve({
-        .equation = Equation{rule.stack, rule.pattern_type, rule.replacement_type}}
-      ).then(report_if_failure(SourceKind::rule_equation, index)).listen([this, rule = std::move(rule), index](bool okay) {
+        .equation = Equation{rule.stack, rule.pattern_type, rule.replacement_type},
+        .trace_label = trace_label(SourceKind::rule_equation, index)
+      }).then(report_if_failure(SourceKind::rule_equation, index)).listen([this, rule = std::move(rule), index](bool okay) {
         if(!okay) {
           return;
         }
+        mdb::Tracer::Span span{expression_context.tracer, "rule: convert", "rule"};
+        span.arg("rule", index);
         auto pat = expression_context.reduce(rule.pattern);
         auto rep = expression_context.reduce(rule.replacement);
         if(auto new_rule = convert_to_rule(pat, rep, expression_context, solver_context.indeterminates)) {
@@ -151,6 +176,8 @@ namespace expression::solver {
               unconstrainable_patterns.push_back({.rule_index = index});
               return;
             }
+            mdb::Tracer::Span span{expression_context.tracer, "rule: evaluate pattern", "rule"};
+            span.arg("rule", index);
             auto archived = archive(constrained_pat->pattern);
             auto evaluated = compiler::evaluate::evaluate_pattern(archived.root(), expression_context);
             std::unordered_set<std::uint64_t> solver_indeterminates;
@@ -171,7 +198,8 @@ namespace expression::solver {
                   cast.stack,
                   cast.source_type,
                   cast.target_type
-                }
+                },
+                .trace_label = trace_label(SourceKind::rule_skeleton, index)
               }).then([this, cast](std::optional<SolveError> error) {
                 if(!error) {
                   solver_context.define_variable(cast.variable, cast.stack.depth(), cast.source);
@@ -183,6 +211,8 @@ namespace expression::solver {
               if(!okay) {
                 return;
               }
+              mdb::Tracer::Span span{expression_context.tracer, "rule: check skeleton", "rule"};
+              span.arg("rule", index);
               std::vector<expression::tree::Expression> capture_vec;
               for(auto cast_var : evaluated.capture_point_variables) capture_vec.push_back(expression::tree::External{cast_var});
               std::vector<mdb::Future<bool> > results;
@@ -196,13 +226,16 @@ namespace expression::solver {
                     Stack::empty(expression_context),
                     std::move(base_value),
                     std::move(new_value)
-                  }
+                  },
+                  .trace_label = trace_label(SourceKind::rule_skeleton_verify, index)
                 }).then(report_if_failure(SourceKind::rule_skeleton_verify, index)));
               }
-              collect(std::move(results)).then(&all_of).listen([this, rule = std::move(rule), constrained_pat = std::move(constrained_pat), evaluated = std::move(evaluated)](bool okay) {
+              collect(std::move(results)).then(&all_of).listen([this, index, rule = std::move(rule), constrained_pat = std::move(constrained_pat), evaluated = std::move(evaluated)](bool okay) {
                 if(!okay) {
                   return;
                 }
+                mdb::Tracer::Span span{expression_context.tracer, "rule: add", "rule"};
+                span.arg("rule", index);
                 struct PatternBuilder {
                   static pattern::Pattern from_outline(compiler::pattern::Pattern const& pat) {
                     return pat.visit(mdb::overloaded{
@@ -235,10 +268,11 @@ namespace expression::solver {
         }
       });
     }
-    Impl(compiler::evaluate::EvaluateResult& input, expression::Context& expression_context, StandardSolverContext in_solver_context)
+    Impl(compiler::evaluate::EvaluateResult& input, expression::Context& expression_context, StandardSolverContext in_solver_context, SourceDescriber describe_source)
       :input(input),
        expression_context(expression_context),
        solver_context(std::move(in_solver_context)),
+       describe_source(std::move(describe_source)),
        solver(mdb::ref(solver_context))
      {
       for(auto [var, reason] : input.variables) {
@@ -250,7 +284,7 @@ namespace expression::solver {
       std::uint64_t cast_index = 0;
       for(auto& cast : input.casts) {
         solver.solve(
-          request::Solve{.equation = Equation{cast.stack, cast.source_type, cast.target_type}}
+          request::Solve{.equation = Equation{cast.stack, cast.source_type, cast.target_type}, .trace_label = trace_label(SourceKind::cast_equation, cast_index)}
         ).then(report_if_failure(SourceKind::cast_equation, cast_index)).listen([cast, this](bool okay) {
           if(okay) {
             solver_context.define_variable(cast.variable, cast.stack.depth(), cast.source);
@@ -265,12 +299,12 @@ namespace expression::solver {
         Then: Match RHS to the domain of that function.
         */
         solver.solve(
-          request::Solve{.equation = Equation{func_cast.stack, func_cast.function_type, func_cast.expected_function_type}}
+          request::Solve{.equation = Equation{func_cast.stack, func_cast.function_type, func_cast.expected_function_type}, .trace_label = trace_label(SourceKind::cast_function_lhs, func_cast_index)}
         ).then(report_if_failure(SourceKind::cast_function_lhs, func_cast_index)).listen([func_cast, this, func_cast_index](bool okay) {
           if(!okay) return;
           solver_context.define_variable(func_cast.function_variable, func_cast.stack.depth(), func_cast.function_value);
           solver.solve(
-            request::Solve{.equation = Equation{func_cast.stack, func_cast.argument_type, func_cast.expected_argument_type}}
+            request::Solve{.equation = Equation{func_cast.stack, func_cast.argument_type, func_cast.expected_argument_type}, .trace_label = trace_label(SourceKind::cast_function_rhs, func_cast_index)}
           ).then(report_if_failure(SourceKind::cast_function_rhs, func_cast_index)).listen([func_cast, this](bool okay) {
             if(!okay) return;
             solver_context.define_variable(func_cast.argument_variable, func_cast.stack.depth(), func_cast.argument_value);
@@ -307,16 +341,28 @@ namespace expression::solver {
       });
     }
     void run() {
-      while(step());
+      try {
+        while(step());
+      } catch(BudgetExceeded const&) {
+        //Settle every outstanding promise; nothing that follows is charged.
+        BudgetScope unlimited{expression_context.budget, nullptr};
+        solver.close();
+        close();
+        throw;
+      }
       solver.close();
       close();
     }
   };
-  Routine::Routine(compiler::evaluate::EvaluateResult& input, expression::Context& expression_context, StandardSolverContext solver_context):impl(std::make_unique<Impl>(input, expression_context, std::move(solver_context))) {}
+  Routine::Routine(compiler::evaluate::EvaluateResult& input, expression::Context& expression_context, StandardSolverContext solver_context, SourceDescriber describe_source):impl(std::make_unique<Impl>(input, expression_context, std::move(solver_context), std::move(describe_source))) {}
   Routine::Routine(Routine&&) = default;
   Routine& Routine::operator=(Routine&&) = default;
   Routine::~Routine() = default;
   void Routine::run() { return impl->run(); }
+  void Routine::run(Budget& budget) {
+    BudgetScope scope{impl->expression_context.budget, &budget};
+    return impl->run();
+  }
   ErrorInfo Routine::get_errors() {
     std::vector<HungRoutineEquationInfo> ret;
     for(auto& hung : impl->hung_equations) {
@@ -332,4 +378,10 @@ namespace expression::solver {
       .unconstrainable_patterns = std::move(impl->unconstrainable_patterns)
     };
   }
+  std::uint64_t Routine::get_equation_count() {
+    return impl->solver.get_equation_count();
+  }
+  SolverStats Routine::get_solver_stats() {
+    return impl->solver.get_stats();
+  }
 }
@@ -4,6 +4,8 @@
 #include "solver.hpp"
 #include "../Compiler/evaluator.hpp"
 #include "standard_solver_context.hpp"
+#include <functional>
+#include <string>
 
 namespace expression::solver {
   enum class SourceKind {
@@ -14,6 +16,8 @@ namespace expression::solver {
     rule_skeleton, //an equation arising from deriving relations among capture-point rule
     rule_skeleton_verify //an equation arising from checking requested relations among capture-points
   };
+  char const* name_of(SourceKind);
+  using SourceDescriber = std::function<std::string(SourceKind, std::uint64_t source_index)>; //e.g. the position in the source code
   struct HungRoutineEquation {
     std::uint64_t equation_base_index;
     SourceKind source_kind;
@@ -37,12 +41,16 @@ namespace expression::solver {
     struct Impl;
     std::unique_ptr<Impl> impl;
   public:
-    Routine(compiler::evaluate::EvaluateResult& input, expression::Context& expression_context, StandardSolverContext solver_context);
+    //When the context has a tracer, equations are labelled with their source, described by describe_source if given.
+    Routine(compiler::evaluate::EvaluateResult& input, expression::Context& expression_context, StandardSolverContext solver_context, SourceDescriber describe_source = {});
     Routine(Routine&&);
     Routine& operator=(Routine&&);
     ~Routine();
     void run();
+    void run(Budget&); //throws BudgetExceeded, leaving the routine closed
     ErrorInfo get_errors();
+    std::uint64_t get_equation_count();
+    SolverStats get_solver_stats();
   };
 };
 
@@ -1,4 +1,8 @@
 #include "solver.hpp"
+#include <algorithm>
+#include <deque>
+#include <exception>
+#include <iomanip>
 #include <unordered_map>
 #include <optional>
 #include <unordered_set>
@@ -11,6 +15,7 @@ namespace expression::solver {
       std::uint64_t equations_remaining;
       std::uint64_t base_index;
       mdb::Promise<std::optional<SolveError> > promise;
+      std::string trace_label;
     };
     struct EquationInfo {
       Equation equation;
@@ -19,7 +24,37 @@ namespace expression::solver {
       bool handled = false; //not necessarily satisfied - but no further action needed
       bool failed = false;
       std::shared_ptr<Listener> listener;
+      std::uint64_t deepening = 0; //deepenings between this and its root equation
+      std::uint64_t examinations = 0;
+      bool queued = false;
+      std::uint64_t park_generation = 0; //incremented each time the equation is parked
     };
+    struct EquationSubtree { //kept apart from EquationInfo, which examine_equation moves out
+      std::vector<std::uint64_t> children;
+      std::uint64_t unhandled = 1; //equations in this subtree not yet handled (including failed ones)
+      std::uint64_t failed = 0;
+    };
+    struct ParkedEquation {
+      std::uint64_t index;
+      std::uint64_t generation; //stale if the equation has since been woken
+    };
+    void collect_externals(tree::Expression const& expr, std::unordered_set<std::uint64_t>& externals) {
+      expr.visit(mdb::overloaded{
+        [&](tree::Apply const& apply) {
+          collect_externals(apply.lhs, externals);
+          collect_externals(apply.rhs, externals);
+        },
+        [&](tree::External const& external) {
+          externals.insert(external.external_index);
+        },
+        [&](tree::Arg const&) {},
+        [&](tree::Data const& data) {
+          data.data.visit_children([&](tree::Expression const& child) {
+            collect_externals(child, externals);
+          });
+        }
+      });
+    }
     enum class AttemptResult {
       nothing,
       handled,
@@ -145,7 +180,7 @@ namespace expression::solver {
     std::variant<std::monostate, AsymmetricHeadFailure, AsymmetricExplodeSpec> get_asymmetric_explode_from_equation(tree::Expression const& lhs, tree::Expression const& rhs, std::unordered_set<std::uint64_t> const& variables) {
       //first must check lhs is head-closed!
       if(auto def_form = is_term_in_definition_form(lhs, variables)) {
-        auto unfolded = unfold(rhs);
+        auto unfolded = unfold(peel_data(rhs).value_or(rhs)); //packed data explodes as the application it stands for
         AsymmetricExplodeSpec ret{
           .pattern_head = def_form->head,
           .pattern_args = std::move(def_form->arg_list),
@@ -169,7 +204,40 @@ namespace expression::solver {
     Context context;
     std::vector<std::unordered_set<std::uint64_t> > indeterminate_contexts;
     std::vector<EquationInfo> equations;
+    std::vector<EquationSubtree> subtrees; //parallel to equations
     std::vector<std::pair<std::uint64_t, mdb::Promise<std::optional<SolveError> > > > waiting_routines;
+    /*
+      Scheduling: equations waiting to be examined sit in a FIFO queue. An
+      equation that cannot make progress is parked on every external in its
+      normal form and on its indeterminate context. It is requeued when one of
+      those externals gains a rule or the context gains an indeterminate.
+    */
+    std::deque<std::uint64_t> queue;
+    std::uint64_t first_unqueued = 0; //equations from this index on have never been queued
+    std::unordered_map<std::uint64_t, std::vector<ParkedEquation> > parked_on_external;
+    std::vector<std::vector<ParkedEquation> > parked_in_context;
+    std::size_t rule_events_seen = 0;
+    SolverStats stats;
+    void add_equation(EquationInfo info) {
+      auto parent = info.parent;
+      equations.push_back(std::move(info));
+      subtrees.emplace_back();
+      if(parent != std::uint64_t(-1)) {
+        subtrees[parent].children.push_back(equations.size() - 1);
+        for(auto ancestor = parent; ancestor != std::uint64_t(-1); ancestor = equations[ancestor].parent) {
+          ++subtrees[ancestor].unhandled;
+        }
+      }
+    }
+    void update_subtree_counts(std::uint64_t index, bool failed) {
+      for(auto ancestor = index; ancestor != std::uint64_t(-1); ancestor = equations[ancestor].parent) {
+        if(failed) {
+          ++subtrees[ancestor].failed;
+        } else {
+          --subtrees[ancestor].unhandled;
+        }
+      }
+    }
     AttemptResult try_to_extract_rule(std::uint64_t index, EquationInfo const& info, Simplification const& lhs, Simplification const& rhs) {
       if(auto extracted_rule = get_rule_from_equation(lhs.expression, rhs.expression, indeterminate_contexts[info.indeterminate_context], context)) {
         context.define_variable(extracted_rule->head, extracted_rule->arg_count, std::move(extracted_rule->replacement));
@@ -180,20 +248,24 @@ namespace expression::solver {
       }
     }
     AttemptResult try_to_deepen(std::uint64_t index, EquationInfo const& info, Simplification const& lhs, Simplification const& rhs) {
+      if(lhs.state == SimplificationState::lambda_like || rhs.state == SimplificationState::lambda_like) {
+        stats.max_deepening_depth = std::max(stats.max_deepening_depth, info.deepening + 1);
+      }
       if(lhs.state == SimplificationState::lambda_like) {
         auto lhs_type = context.expression_context().get_domain_and_codomain(
           info.equation.stack.type_of(context.expression_context(), lhs.expression)
         );
         if(!lhs_type) std::terminate();
-        equations.push_back({
+        add_equation({
           .equation = {
-            .stack = info.equation.stack.extend(context.expression_context(), std::move(lhs_type->domain)),
+            .stack = info.equation.stack.extend(context.expression_context(), context.expression_context().reduce(std::move(lhs_type->domain))),
             .lhs =  tree::Apply{lhs.expression, tree::Arg{info.equation.stack.depth()}},
             .rhs = tree::Apply{rhs.expression, tree::Arg{info.equation.stack.depth()}}
           },
           .indeterminate_context = info.indeterminate_context,
           .parent = index,
-          .listener = info.listener
+          .listener = info.listener,
+          .deepening = info.deepening + 1
         });
         ++info.listener->equations_remaining;
         return AttemptResult::handled;
@@ -202,15 +274,16 @@ namespace expression::solver {
           info.equation.stack.type_of(context.expression_context(), rhs.expression)
         );
         if(!rhs_type) std::terminate();
-        equations.push_back({
+        add_equation({
           .equation = {
-            .stack = info.equation.stack.extend(context.expression_context(), std::move(rhs_type->domain)),
+            .stack = info.equation.stack.extend(context.expression_context(), context.expression_context().reduce(std::move(rhs_type->domain))),
             .lhs =  tree::Apply{lhs.expression, tree::Arg{info.equation.stack.depth()}},
             .rhs = tree::Apply{rhs.expression, tree::Arg{info.equation.stack.depth()}}
           },
           .indeterminate_context = info.indeterminate_context,
           .parent = index,
-          .listener = info.listener
+          .listener = info.listener,
+          .deepening = info.deepening + 1
         });
         ++info.listener->equations_remaining;
         return AttemptResult::handled;
@@ -220,11 +293,21 @@ namespace expression::solver {
     }
     AttemptResult try_to_explode_symmetric(std::uint64_t index, EquationInfo const& info, Simplification const& lhs, Simplification const& rhs) {
       if(lhs.state == SimplificationState::head_closed && rhs.state == SimplificationState::head_closed) {
-        auto unfold_lhs = unfold(lhs.expression);
-        auto unfold_rhs = unfold(rhs.expression);
-        if(unfold_lhs.head == unfold_rhs.head && unfold_lhs.args.size() == unfold_rhs.args.size()) {
+        auto same_shape = [](tree::Expression const& lhs, tree::Expression const& rhs) {
+          return spine_head(lhs) == spine_head(rhs) && spine_arg_count(lhs) == spine_arg_count(rhs);
+        };
+        tree::Expression const* lhs_expr = &lhs.expression;
+        tree::Expression const* rhs_expr = &rhs.expression;
+        std::optional<tree::Expression> peeled;
+        if(!same_shape(*lhs_expr, *rhs_expr)) { //packed data against anything else is compared as the application it stands for
+          if(!rhs_expr->holds_data() && (peeled = peel_data(*lhs_expr))) lhs_expr = &*peeled;
+          else if(!lhs_expr->holds_data() && (peeled = peel_data(*rhs_expr))) rhs_expr = &*peeled;
+        }
+        if(same_shape(*lhs_expr, *rhs_expr)) {
+          auto unfold_lhs = unfold(*lhs_expr);
+          auto unfold_rhs = unfold(*rhs_expr);
           for(std::uint64_t i = 0; i < unfold_lhs.args.size(); ++i) {
-            equations.push_back({
+            add_equation({
               .equation = {
                 .stack = info.equation.stack,
                 .lhs = unfold_lhs.args[i],
@@ -232,7 +315,8 @@ namespace expression::solver {
               },
               .indeterminate_context = info.indeterminate_context,
               .parent = index,
-              .listener = info.listener
+              .listener = info.listener,
+              .deepening = info.deepening
             });
           }
           info.listener->equations_remaining += unfold_lhs.args.size();
@@ -251,11 +335,11 @@ namespace expression::solver {
         );
         if(!next_type_opt) std::terminate();
         auto var = context.introduce_variable(info.equation.stack.instance_of_type_family(context.expression_context(),
-         std::move(next_type_opt->domain)
+         context.expression_context().reduce(std::move(next_type_opt->domain))
        ));
         indeterminate_contexts[info.indeterminate_context].insert(var);
         replacement = tree::Apply{std::move(replacement), apply_args_enumerated(tree::External{var}, spec.pattern_args.size())};
-        equations.push_back({
+        add_equation({
           .equation = {
             .stack = info.equation.stack,
             .lhs = apply_args_vector(tree::External{var}, spec.pattern_args),
@@ -263,10 +347,12 @@ namespace expression::solver {
           },
           .indeterminate_context = info.indeterminate_context,
           .parent = index,
-          .listener = info.listener
+          .listener = info.listener,
+          .deepening = info.deepening
         });
       }
       info.listener->equations_remaining += spec.irreducible_args.size();
+      stats.explosion_variables += spec.irreducible_args.size();
 
       context.define_variable(
         spec.pattern_head,
@@ -301,28 +387,58 @@ namespace expression::solver {
         return AttemptResult::nothing;
       }
     }
+    template<class Test>
+    AttemptResult attempt(Test test, SolverStats::RuleCounts& counts, std::uint64_t index, EquationInfo const& info, Simplification const& lhs, Simplification const& rhs) {
+      ++counts.attempts;
+      auto ret = (this->*test)(index, info, lhs, rhs);
+      if(ret == AttemptResult::handled) ++counts.handled;
+      if(ret == AttemptResult::failed) ++counts.failed;
+      return ret;
+    }
     bool examine_equation(std::uint64_t index) {
       auto info = std::move(equations[index]); //move the equation *out* of the stack - so it can't move
       if(info.handled || info.failed) std::terminate(); //precondition
+      struct RestoreOnThrow { //a budget may run out part way through; close() still needs the listener
+        std::vector<EquationInfo>& equations;
+        std::uint64_t index;
+        EquationInfo& info;
+        int exceptions = std::uncaught_exceptions();
+        ~RestoreOnThrow() {
+          if(std::uncaught_exceptions() > exceptions) equations[index] = std::move(info);
+        }
+      } restore_on_throw{equations, index, info};
+      ++stats.examinations;
+      stats.max_examinations = std::max(stats.max_examinations, ++info.examinations);
       auto lhs = context.simplify(std::move(info.equation.lhs));
       auto rhs = context.simplify(std::move(info.equation.rhs));
+      bool lhs_closed = lhs.state == SimplificationState::head_closed;
+      bool rhs_closed = rhs.state == SimplificationState::head_closed;
+      if(lhs_closed != rhs_closed) { //only symmetric explosion can do without normal forms
+        auto& closed = lhs_closed ? lhs : rhs;
+        closed.expression = context.expression_context().reduce(std::move(closed.expression));
+      }
 
       AttemptResult ret = AttemptResult::nothing;
       std::apply([&](auto... tests) {
-        (is_definitive(ret = (this->*tests)(index, info, lhs, rhs)) || ...);
+        (is_definitive(ret = attempt(tests.first, stats.*tests.second, index, info, lhs, rhs)) || ...);
       }, std::make_tuple(
-        &Impl::try_to_extract_rule,
-        &Impl::try_to_deepen,
-        &Impl::try_to_explode_symmetric,
-        &Impl::try_to_explode_asymmetric,
-        &Impl::try_to_judge_equal)
+        std::make_pair(&Impl::try_to_extract_rule, &SolverStats::extract_rule),
+        std::make_pair(&Impl::try_to_deepen, &SolverStats::deepen),
+        std::make_pair(&Impl::try_to_explode_symmetric, &SolverStats::explode_symmetric),
+        std::make_pair(&Impl::try_to_explode_asymmetric, &SolverStats::explode_asymmetric),
+        std::make_pair(&Impl::try_to_judge_equal, &SolverStats::judge_equal))
       );
+      if(is_definitive(ret)) {
+        ++stats.equations_resolved;
+        stats.examinations_to_resolve += info.examinations;
+      }
       auto& info_final = equations[index]; //Vector might move!!!
       info_final = std::move(info); //move it back
       info_final.equation.lhs = std::move(lhs.expression);
       info_final.equation.rhs = std::move(rhs.expression);
       if(ret == AttemptResult::handled) {
         info_final.handled = true;
+        update_subtree_counts(index, false);
         if(--info_final.listener->equations_remaining == 0) {
           info_final.listener->handled = true;
           info_final.listener->promise.set_value(std::nullopt); //solved!
@@ -330,6 +446,9 @@ namespace expression::solver {
         return true;
       } else if(ret == AttemptResult::failed) {
         info_final.failed = true;
+        info_final.equation.lhs = context.expression_context().reduce(std::move(info_final.equation.lhs)); //for reporting
+        info_final.equation.rhs = context.expression_context().reduce(std::move(info_final.equation.rhs));
+        update_subtree_counts(index, true);
         if(!info_final.listener->handled) {
           info_final.listener->handled = true;
           info_final.listener->promise.set_value(SolveError{
@@ -343,43 +462,68 @@ namespace expression::solver {
       }
     }
     bool is_equation_satisfied(std::uint64_t index) {
-      std::unordered_set<std::uint64_t> requirements;
-      auto check_required_equation = [&](std::uint64_t i) {
-        if(equations[i].handled) {
-          requirements.insert(i);
-          return true;
-        } else {
-          return false;
-        }
+      return subtrees[index].unhandled == 0;
+    }
+    void park(std::uint64_t index) {
+      auto& info = equations[index];
+      ParkedEquation entry{
+        .index = index,
+        .generation = ++info.park_generation
       };
-      if(!check_required_equation(index)) return false;
-      for(std::uint64_t i = index + 1; i < equations.size(); ++i) {
-        if(requirements.contains(equations[i].parent)) {
-          if(!check_required_equation(i)) return false;
+      std::unordered_set<std::uint64_t> externals;
+      collect_externals(info.equation.lhs, externals);
+      collect_externals(info.equation.rhs, externals);
+      for(auto external : externals) {
+        parked_on_external[external].push_back(entry);
+      }
+      if(parked_in_context.size() <= info.indeterminate_context) {
+        parked_in_context.resize(info.indeterminate_context + 1);
+      }
+      parked_in_context[info.indeterminate_context].push_back(entry);
+    }
+    void wake(std::vector<ParkedEquation>& parked) {
+      for(auto const& entry : parked) {
+        auto& info = equations[entry.index];
+        if(!info.queued && !info.handled && !info.failed && info.park_generation == entry.generation) {
+          info.queued = true;
+          queue.push_back(entry.index);
+        }
+      }
+      parked.clear();
+    }
+    void update_queue() {
+      for(; first_unqueued < equations.size(); ++first_unqueued) {
+        equations[first_unqueued].queued = true;
+        queue.push_back(first_unqueued);
+      }
+      auto const& rule_events = context.expression_context().rule_events;
+      for(; rule_events_seen < rule_events.size(); ++rule_events_seen) {
+        if(auto it = parked_on_external.find(rule_events[rule_events_seen]); it != parked_on_external.end()) {
+          wake(it->second);
+          parked_on_external.erase(it);
         }
       }
-      return true;
     }
     bool try_to_make_progress() {
       bool made_progress = false;
-      std::uint64_t start_point = 0;
-    DEDUCE_START:
-      for(std::uint64_t i = start_point; i < equations.size(); ++i) {
-        if(!equations[i].handled && !equations[i].failed) {
-          if(examine_equation(i)) {
-            made_progress = true;
-            start_point = i + 1;
-            goto DEDUCE_START;
-          }
+      for(update_queue(); !queue.empty(); update_queue()) {
+        auto index = queue.front();
+        queue.pop_front();
+        equations[index].queued = false;
+        if(equations[index].handled || equations[index].failed) continue;
+        context.expression_context().charge_step();
+        mdb::Tracer::Span span{context.expression_context().tracer, "examine_equation", "solver"};
+        if(span) {
+          span.arg("equation", index);
+          span.arg("root equation", equations[index].listener->base_index);
+          span.arg("source", equations[index].listener->trace_label);
         }
-      }
-      for(std::uint64_t i = 0; i < start_point; ++i) {
-        if(!equations[i].handled && !equations[i].failed) {
-          if(examine_equation(i)) {
-            made_progress = true;
-            start_point = i + 1;
-            goto DEDUCE_START;
-          }
+        if(examine_equation(index)) {
+          made_progress = true;
+          span.arg("outcome", "progress");
+        } else {
+          park(index);
+          span.arg("outcome", "parked");
         }
       }
       return made_progress;
@@ -393,6 +537,9 @@ namespace expression::solver {
     }
     void register_indeterminate(request::RegisterIndeterminate register_indeterminate) {
       indeterminate_contexts[register_indeterminate.indeterminate_context.index].insert(register_indeterminate.new_variable);
+      if(register_indeterminate.indeterminate_context.index < parked_in_context.size()) {
+        wake(parked_in_context[register_indeterminate.indeterminate_context.index]);
+      }
     }
     mdb::Future<std::optional<SolveError> > solve(request::Solve solve) {
       auto eq_index = equations.size();
@@ -400,9 +547,10 @@ namespace expression::solver {
       auto listener = std::shared_ptr<Listener>{new Listener{
         .equations_remaining = 1,
         .base_index = eq_index,
-        .promise = std::move(promise)
+        .promise = std::move(promise),
+        .trace_label = std::move(solve.trace_label)
       }};
-      equations.push_back({
+      add_equation({
         .equation = std::move(solve.equation),
         .indeterminate_context = solve.indeterminate_context.index,
         .listener = std::move(listener)
@@ -428,24 +576,24 @@ namespace expression::solver {
       }
     }
     SolveErrorInfo get_error_info(std::uint64_t index) {
-      std::unordered_set<std::uint64_t> requirements;
       SolveErrorInfo ret{
         .primary = equations[index].equation
       };
-      auto check_required_equation = [&](std::uint64_t i) {
-        if(i != index) {
-          if(equations[i].failed) {
-            ret.secondary_fail.push_back(equations[i].equation);
-          } else if(!equations[i].handled) {
-            ret.secondary_stuck.push_back(equations[i].equation);
-          }
-        }
-        requirements.insert(i);
-      };
-      check_required_equation(index);
-      for(std::uint64_t i = index + 1; i < equations.size(); ++i) {
-        if(requirements.contains(equations[i].parent)) {
-          check_required_equation(i);
+      std::vector<std::uint64_t> reported; //descendants which are failed or stuck
+      std::vector<std::uint64_t> to_visit = subtrees[index].children;
+      while(!to_visit.empty()) {
+        auto i = to_visit.back();
+        to_visit.pop_back();
+        if(subtrees[i].unhandled == 0) continue; //everything below is handled
+        if(!equations[i].handled) reported.push_back(i);
+        to_visit.insert(to_visit.end(), subtrees[i].children.begin(), subtrees[i].children.end());
+      }
+      std::sort(reported.begin(), reported.end()); //report in order of creation
+      for(auto i : reported) {
+        if(equations[i].failed) {
+          ret.secondary_fail.push_back(equations[i].equation);
+        } else {
+          ret.secondary_stuck.push_back(equations[i].equation);
         }
       }
       return ret;
@@ -453,6 +601,7 @@ namespace expression::solver {
   };
   Solver::Solver(Context context):impl(new Impl{.context = std::move(context)}) {
     impl->indeterminate_contexts.emplace_back();
+    impl->rule_events_seen = impl->context.expression_context().rule_events.size(); //nothing is parked on earlier events
   }
   IndeterminateContext Solver::create_context(request::CreateContext create_context) {
     return impl->create_context(std::move(create_context));
@@ -466,12 +615,41 @@ namespace expression::solver {
   bool Solver::try_to_make_progress() {
     return impl->try_to_make_progress();
   }
+  bool Solver::try_to_make_progress(Budget& budget) {
+    BudgetScope scope{impl->context.expression_context().budget, &budget};
+    return impl->try_to_make_progress();
+  }
   void Solver::close() {
     return impl->close();
   }
   SolveErrorInfo Solver::get_error_info(std::uint64_t equation_id) {
     return impl->get_error_info(equation_id);
   }
+  std::uint64_t Solver::get_equation_count() {
+    return impl->equations.size();
+  }
+  SolverStats Solver::get_stats() {
+    return impl->stats;
+  }
+  std::ostream& operator<<(std::ostream& output, SolverStats const& stats) {
+    std::pair<char const*, SolverStats::RuleCounts const*> rules[] = {
+      {"extract rule", &stats.extract_rule},
+      {"deepen", &stats.deepen},
+      {"explode (sym)", &stats.explode_symmetric},
+      {"explode (asym)", &stats.explode_asymmetric},
+      {"judge equal", &stats.judge_equal}
+    };
+    output << std::left << std::setw(16) << "Solver rule" << std::right << std::setw(10) << "Attempts" << std::setw(10) << "Handled" << std::setw(10) << "Failed" << std::setw(10) << "Misses" << "\n";
+    for(auto const& [name, counts] : rules) {
+      output << std::left << std::setw(16) << name << std::right << std::setw(10) << counts->attempts << std::setw(10) << counts->handled
+             << std::setw(10) << counts->failed << std::setw(10) << counts->misses() << "\n";
+    }
+    output << std::left;
+    output << "Examinations: " << stats.examinations << " (" << stats.equations_resolved << " equations resolved in " << stats.examinations_to_resolve << " of them"
+           << ", at most " << stats.max_examinations << " of one equation)\n";
+    output << "Deepest deepening: " << stats.max_deepening_depth << ", variables introduced by explosion: " << stats.explosion_variables << "\n";
+    return output;
+  }
 
   Solver::Solver(Solver&&) = default;
   Solver& Solver::operator=(Solver&&) = default;
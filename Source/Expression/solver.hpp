@@ -4,7 +4,9 @@
 #include "expression_tree.hpp"
 #include "solver_context.hpp"
 #include "stack.hpp"
+#include "budget.hpp"
 #include <memory>
+#include <ostream>
 #include <unordered_set>
 #include "../Utility/async.hpp"
 
@@ -96,6 +98,7 @@ namespace expression::solver {
     struct Solve {
       IndeterminateContext indeterminate_context;
       Equation equation;
+      std::string trace_label = {}; //names the source of the equation and those derived from it in traces
     };
   }
   struct SolveErrorInfo {
@@ -103,6 +106,26 @@ namespace expression::solver {
     std::vector<Equation> secondary_fail;
     std::vector<Equation> secondary_stuck;
   };
+  struct SolverStats { //counts over the life of one solver
+    struct RuleCounts {
+      std::uint64_t attempts = 0;
+      std::uint64_t handled = 0; //resolved the equation
+      std::uint64_t failed = 0; //refuted the equation
+      std::uint64_t misses() const { return attempts - handled - failed; }
+    };
+    RuleCounts extract_rule;
+    RuleCounts deepen;
+    RuleCounts explode_symmetric;
+    RuleCounts explode_asymmetric;
+    RuleCounts judge_equal;
+    std::uint64_t examinations = 0;
+    std::uint64_t equations_resolved = 0; //handled or failed
+    std::uint64_t examinations_to_resolve = 0; //summed over resolved equations
+    std::uint64_t max_examinations = 0; //of any one equation
+    std::uint64_t max_deepening_depth = 0; //longest chain of deepenings leading to an equation
+    std::uint64_t explosion_variables = 0; //introduced by asymmetric explosion
+  };
+  std::ostream& operator<<(std::ostream&, SolverStats const&);
   class Solver {
     struct Impl;
     std::unique_ptr<Impl> impl;
@@ -115,8 +138,11 @@ namespace expression::solver {
     void register_indeterminate(request::RegisterIndeterminate);
     mdb::Future<std::optional<SolveError> > solve(request::Solve);
     bool try_to_make_progress(); //returns true if progress was made.
+    bool try_to_make_progress(Budget&); //throws BudgetExceeded; close() the solver before discarding it
     void close(); //releases all routines connected to this one.
     SolveErrorInfo get_error_info(std::uint64_t equation_id);
+    std::uint64_t get_equation_count(); //every equation created so far, including those derived from others
+    SolverStats get_stats();
   };
 }
 
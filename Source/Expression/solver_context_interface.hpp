@@ -29,7 +29,7 @@ namespace expression::solver {
   };
   struct Simplification {
     SimplificationState state;
-    tree::Expression expression;
+    tree::Expression expression; //normalized, except for the arguments of head_closed expressions
   };
 }
 
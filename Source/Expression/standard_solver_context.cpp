@@ -10,41 +10,20 @@ namespace expression::solver {
       }
       return ret;
     }
-    bool is_lambda_like(tree::Expression const& expr, expression::Context const& evaluation) {
-      for(auto const& rule : evaluation.rules) {
-        pattern::Pattern const* segment = &rule.pattern;
-        while(auto* apply = segment->get_if_apply()) {
-          if(!apply->rhs.holds_wildcard()) break;
-          segment = &apply->lhs;
-          if(term_matches(expr, *segment)) {
-            return true;
-          }
-        }
-      }
-      return false;
-    }
   }
   Simplification StandardSolverContext::simplify(tree::Expression base) {
-    auto simplified = evaluation.reduce(base);
-    auto unfolded = unfold(simplified);
-    SimplificationState state = [&] {
-      if(unfolded.head.holds_arg() || unfolded.head.holds_data()) {
-        return SimplificationState::head_closed;
-      } else {
-        auto const& external = unfolded.head.get_external();
-        if(evaluation.external_info[external.external_index].is_axiom) {
-          return SimplificationState::head_closed;
-        } else {
-          if(is_lambda_like(simplified, evaluation)) {
-            return SimplificationState::lambda_like;
-          } else {
-            return SimplificationState::open;
-          }
-        }
-      }
-    }();
+    //Head-closed expressions are only ever exploded, so their arguments are left for the new equations to reduce.
+    auto simplified = evaluation.reduce_whnf(std::move(base));
+    auto const& head = spine_head(simplified);
+    if(head.holds_arg() || head.holds_data() || evaluation.external_info[head.get_external().external_index].is_axiom) {
+      return {
+        .state = SimplificationState::head_closed,
+        .expression = std::move(simplified)
+      };
+    }
+    simplified = evaluation.reduce(std::move(simplified));
     return {
-      .state = state,
+      .state = evaluation.is_lambda_like(simplified) ? SimplificationState::lambda_like : SimplificationState::open,
       .expression = std::move(simplified)
     };
   }
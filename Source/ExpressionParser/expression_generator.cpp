@@ -266,6 +266,12 @@ namespace expression_parser {
             .position = locator.to_span(span.span_begin - 1, span.span_begin)
           }};
         },
+        [&](lex_archive::BigIntegerLiteral const& literal) -> ExprResult {
+          return located_output::Expression{located_output::Literal{
+            .value = literal::BigInteger{std::string{literal.digits}},
+            .position = locator.to_span(span.span_begin - 1, span.span_begin)
+          }};
+        },
         [&](lex_archive::ParenthesizedExpression const& parens) -> ExprResult {
           if(should_parse_dependent_arrow(parens)) {
             return parse_dependent_arrow(locator, parens, span);
@@ -439,6 +445,50 @@ namespace expression_parser {
         .position = locator.to_span(let_start, span.span_begin)
       }};
     }
+    CommandResult parse_pragma(LocatorInfo const& locator, LexerSpan& span) { //pointed *at* "pragma"
+      auto pragma_start = span.begin();
+      ++span.span_begin;
+      if(span.empty() || !span.span_begin->holds_word()) {
+        return ParseError{
+          .position = (span.span_begin - 1)->index(),
+          .message = "Expected pragma name after 'pragma'."
+        };
+      }
+      if(span.span_begin->get_word().text != "packed_nat") {
+        return ParseError{
+          .position = span.span_begin->index(),
+          .message = "Unknown pragma. The only pragma is 'packed_nat'."
+        };
+      }
+      ++span.span_begin;
+      if(span.empty()) {
+        return ParseError{
+          .position = (span.span_begin - 1)->index(),
+          .message = "Expected zero and successor after 'packed_nat'."
+        };
+      }
+      auto zero = parse_term(locator, span);
+      if(zero.holds_error()) return std::move(zero.get_error());
+      if(span.empty()) {
+        return ParseError{
+          .position = (span.span_begin - 1)->index(),
+          .message = "Expected successor after zero in 'packed_nat'."
+        };
+      }
+      auto succ = parse_term(locator, span);
+      if(succ.holds_error()) return std::move(succ.get_error());
+      if(!span.empty()) {
+        return ParseError{
+          .position = span.span_begin->index(),
+          .message = "Expected end of statement after successor in 'packed_nat'."
+        };
+      }
+      return located_output::Command{located_output::PackedNat{
+        .zero = std::move(zero.get_value()),
+        .succ = std::move(succ.get_value()),
+        .position = locator.to_span(pragma_start, span.span_begin)
+      }};
+    }
     PatternResult parse_pattern(LocatorInfo const& locator, LexerSpan& span) {
       auto parse_term = [&]() -> PatternResult {
         if(auto* word = span.span_begin->get_if_word()) {
@@ -519,6 +569,7 @@ namespace expression_parser {
           case symbols::declare: return parse_declare_or_axiom(locator, span, false);
           case symbols::axiom: return parse_declare_or_axiom(locator, span, true);
           case symbols::let: return parse_let(locator, span);
+          case symbols::pragma: return parse_pragma(locator, span);
           case symbols::rule: {
             ++span.span_begin;
             if(span.empty()) {
@@ -187,7 +187,17 @@ namespace expression_parser {
       } else if(auto* at_pointer = std::get_if<tokens::AtPointer>(&next_token)) {
         switch(*at_pointer) {
           case tokens::AtPointer::digit: {
+            auto digits = str;
             auto value = parse_integer_literal(str);
+            if(str.starts_with('n') && (str.size() == 1 || !(std::isalnum(str[1]) || str[1] == '_'))) { //big integer suffix
+              digits = string_between(digits.data(), str.data());
+              str.remove_prefix(1);
+              terms.push_back(lex_located_output::BigIntegerLiteral{
+                .digits = digits,
+                .position = string_between(token_str.data(), str.data())
+              });
+              goto PARSE_NEXT_TOKEN;
+            }
             terms.push_back(lex_located_output::IntegerLiteral{
               .value = value,
               .position = string_between(token_str.data(), str.data())
@@ -6,6 +6,7 @@ shape = CompoundShape({
         "Word": [],
         "StringLiteral": [],
         "IntegerLiteral": [],
+        "BigIntegerLiteral": [],
         "ParenthesizedExpression": [
             ("body", vector("Term"))
         ],
@@ -31,6 +32,9 @@ output = shape.generate_instance(namespace = "expression_parser::lex_output", da
         "IntegerLiteral": [
             ("value", "std::uint64_t")
         ],
+        "BigIntegerLiteral": [
+            ("digits", "std::string_view")
+        ],
         "ParenthesizedExpression": [],
         "BraceExpression": [],
         "BracketExpression": []
@@ -50,6 +54,9 @@ locator = shape.generate_instance(namespace = "expression_parser::lex_locator",
         "IntegerLiteral": [
             ("position", "std::string_view")
         ],
+        "BigIntegerLiteral": [
+            ("position", "std::string_view")
+        ],
         "ParenthesizedExpression": [
             ("position", "std::string_view")
         ],
@@ -6,7 +6,11 @@
 #include <string>
 
 namespace expression_parser::literal {
-  using Any = std::variant<std::uint64_t, std::string>;
+  struct BigInteger {
+    std::string digits; //decimal
+    friend bool operator==(BigInteger const&, BigInteger const&) = default;
+  };
+  using Any = std::variant<std::uint64_t, std::string, BigInteger>;
 }
 
 #endif
@@ -373,6 +373,14 @@ namespace expression_parser {
           } ();
           command_context.add_name(let.name);
           return ret;
+        },
+        [&](output_archive::PackedNat const& packed_nat) -> mdb::Result<resolved::Command, ResolutionError> {
+          return merged_result([&](resolved::Expression zero, resolved::Expression succ) -> resolved::Command {
+            return resolved::PackedNat{
+              .zero = std::move(zero),
+              .succ = std::move(succ)
+            };
+          }, resolve_impl(command_context, command_context.next_index, packed_nat.zero), resolve_impl(command_context, command_context.next_index, packed_nat.succ));
         }
       });
     }
@@ -47,6 +47,10 @@ shape = CompoundShape({
         "Let": [
             ("value", "Expression"),
             ("type", optional("Expression"))
+        ],
+        "PackedNat": [
+            ("zero", "Expression"),
+            ("succ", "Expression")
         ]
     }
 })
@@ -86,7 +90,8 @@ output = shape.generate_instance(namespace = "expression_parser::output", data =
         ],
         "Let": [
             ("name", "std::string_view")
-        ]
+        ],
+        "PackedNat": []
     }
 })
 locator = shape.generate_instance(namespace = "expression_parser::locator", data = {
@@ -139,6 +144,9 @@ locator = shape.generate_instance(namespace = "expression_parser::locator", data
         ],
         "Let": [
             ("position", "LexerSpanIndex")
+        ],
+        "PackedNat": [
+            ("position", "LexerSpanIndex")
         ]
     }
 })
@@ -174,7 +182,8 @@ resolution = shape.generate_instance(namespace = "expression_parser::resolved",
             ("args_in_pattern", "std::uint64_t")
         ],
         "Axiom": [],
-        "Let": []
+        "Let": [],
+        "PackedNat": []
     }
 })
 located_output = Multitree("expression_parser::located_output", {
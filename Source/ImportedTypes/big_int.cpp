@@ -0,0 +1,297 @@
+#include "big_int.hpp"
+#include <algorithm>
+#include <bit>
+#include <span>
+
+namespace imported_type {
+  namespace {
+    using Magnitude = std::vector<std::uint32_t>;
+    constexpr std::size_t karatsuba_threshold = 32; //limbs in the shorter factor
+    constexpr std::uint32_t decimal_chunk = 1000000000; //largest power of ten in a limb
+
+    void trim(Magnitude& value) {
+      while(!value.empty() && value.back() == 0) value.pop_back();
+    }
+    std::span<std::uint32_t const> trimmed(std::span<std::uint32_t const> value) {
+      while(!value.empty() && value.back() == 0) value = value.first(value.size() - 1);
+      return value;
+    }
+    std::strong_ordering compare_magnitude(std::span<std::uint32_t const> lhs, std::span<std::uint32_t const> rhs) {
+      if(lhs.size() != rhs.size()) return lhs.size() <=> rhs.size();
+      for(std::size_t i = lhs.size(); i-- > 0;) {
+        if(lhs[i] != rhs[i]) return lhs[i] <=> rhs[i];
+      }
+      return std::strong_ordering::equal;
+    }
+    Magnitude add_magnitude(std::span<std::uint32_t const> lhs, std::span<std::uint32_t const> rhs) {
+      if(lhs.size() < rhs.size()) std::swap(lhs, rhs);
+      Magnitude ret(lhs.size() + 1);
+      std::uint64_t carry = 0;
+      for(std::size_t i = 0; i < lhs.size(); ++i) {
+        std::uint64_t sum = carry + lhs[i] + (i < rhs.size() ? rhs[i] : 0);
+        ret[i] = std::uint32_t(sum);
+        carry = sum >> 32;
+      }
+      ret[lhs.size()] = std::uint32_t(carry);
+      trim(ret);
+      return ret;
+    }
+    Magnitude sub_magnitude(std::span<std::uint32_t const> lhs, std::span<std::uint32_t const> rhs) { //requires lhs >= rhs
+      Magnitude ret(lhs.size());
+      std::int64_t borrow = 0;
+      for(std::size_t i = 0; i < lhs.size(); ++i) {
+        std::int64_t diff = std::int64_t(lhs[i]) - borrow - (i < rhs.size() ? rhs[i] : 0);
+        borrow = diff < 0;
+        ret[i] = std::uint32_t(diff + (borrow << 32));
+      }
+      trim(ret);
+      return ret;
+    }
+    void add_shifted(Magnitude& target, Magnitude const& value, std::size_t offset) { //target += value << (32 * offset)
+      if(target.size() < offset + value.size() + 1) target.resize(offset + value.size() + 1);
+      std::uint64_t carry = 0;
+      std::size_t i = 0;
+      for(; i < value.size(); ++i) {
+        std::uint64_t sum = carry + target[offset + i] + value[i];
+        target[offset + i] = std::uint32_t(sum);
+        carry = sum >> 32;
+      }
+      for(; carry; ++i) {
+        if(offset + i == target.size()) target.push_back(0);
+        std::uint64_t sum = carry + target[offset + i];
+        target[offset + i] = std::uint32_t(sum);
+        carry = sum >> 32;
+      }
+    }
+    Magnitude schoolbook_multiply(std::span<std::uint32_t const> lhs, std::span<std::uint32_t const> rhs) {
+      Magnitude ret(lhs.size() + rhs.size());
+      for(std::size_t i = 0; i < lhs.size(); ++i) {
+        std::uint64_t carry = 0;
+        for(std::size_t j = 0; j < rhs.size(); ++j) {
+          std::uint64_t product = std::uint64_t(lhs[i]) * rhs[j] + ret[i + j] + carry;
+          ret[i + j] = std::uint32_t(product);
+          carry = product >> 32;
+        }
+        ret[i + rhs.size()] = std::uint32_t(carry);
+      }
+      trim(ret);
+      return ret;
+    }
+    Magnitude multiply_magnitude(std::span<std::uint32_t const> lhs, std::span<std::uint32_t const> rhs) {
+      lhs = trimmed(lhs);
+      rhs = trimmed(rhs);
+      if(lhs.size() < rhs.size()) std::swap(lhs, rhs);
+      if(rhs.size() < karatsuba_threshold) return schoolbook_multiply(lhs, rhs);
+      auto half = lhs.size() / 2;
+      auto lhs_low = lhs.first(half);
+      auto lhs_high = lhs.subspan(half);
+      if(rhs.size() <= half) { //unbalanced: split only the longer factor
+        auto ret = multiply_magnitude(lhs_low, rhs);
+        add_shifted(ret, multiply_magnitude(lhs_high, rhs), half);
+        trim(ret);
+        return ret;
+      }
+      auto rhs_low = rhs.first(half);
+      auto rhs_high = rhs.subspan(half);
+      auto low = multiply_magnitude(lhs_low, rhs_low);
+      auto high = multiply_magnitude(lhs_high, rhs_high);
+      auto middle = multiply_magnitude(add_magnitude(trimmed(lhs_low), lhs_high), add_magnitude(trimmed(rhs_low), rhs_high));
+      middle = sub_magnitude(sub_magnitude(middle, low), high);
+      auto ret = low;
+      add_shifted(ret, middle, half);
+      add_shifted(ret, high, 2 * half);
+      trim(ret);
+      return ret;
+    }
+    std::uint32_t divide_by_limb(Magnitude& value, std::uint32_t divisor) { //in place; returns the remainder
+      std::uint64_t remainder = 0;
+      for(std::size_t i = value.size(); i-- > 0;) {
+        std::uint64_t current = (remainder << 32) | value[i];
+        value[i] = std::uint32_t(current / divisor);
+        remainder = current % divisor;
+      }
+      trim(value);
+      return std::uint32_t(remainder);
+    }
+    std::pair<Magnitude, Magnitude> divide_magnitude(Magnitude const& dividend, Magnitude const& divisor) { //requires divisor non-zero
+      if(compare_magnitude(dividend, divisor) < 0) return {Magnitude{}, dividend};
+      if(divisor.size() == 1) {
+        auto quotient = dividend;
+        auto remainder = divide_by_limb(quotient, divisor[0]);
+        Magnitude rest{remainder};
+        trim(rest);
+        return {std::move(quotient), std::move(rest)};
+      }
+      //Knuth's algorithm D, with both operands normalized so the divisor's top limb has its high bit set.
+      auto n = divisor.size();
+      auto m = dividend.size() - n;
+      auto shift = std::countl_zero(divisor.back());
+      Magnitude v(n);
+      Magnitude u(dividend.size() + 1);
+      for(std::size_t i = n; i-- > 0;) {
+        v[i] = (divisor[i] << shift) | (shift && i > 0 ? divisor[i - 1] >> (32 - shift) : 0);
+      }
+      u[dividend.size()] = shift ? dividend.back() >> (32 - shift) : 0;
+      for(std::size_t i = dividend.size(); i-- > 0;) {
+        u[i] = (dividend[i] << shift) | (shift && i > 0 ? dividend[i - 1] >> (32 - shift) : 0);
+      }
+      Magnitude quotient(m + 1);
+      constexpr std::uint64_t base = std::uint64_t(1) << 32;
+      for(std::size_t j = m + 1; j-- > 0;) {
+        std::uint64_t numerator = (std::uint64_t(u[j + n]) << 32) | u[j + n - 1];
+        std::uint64_t q_hat = numerator / v[n - 1];
+        std::uint64_t r_hat = numerator % v[n - 1];
+        while(q_hat >= base || q_hat * v[n - 2] > ((r_hat << 32) | u[j + n - 2])) {
+          --q_hat;
+          r_hat += v[n - 1];
+          if(r_hat >= base) break;
+        }
+        std::int64_t borrow = 0;
+        for(std::size_t i = 0; i < n; ++i) {
+          std::uint64_t product = q_hat * v[i];
+          std::int64_t diff = std::int64_t(u[i + j]) - borrow - std::int64_t(product & 0xFFFFFFFF);
+          u[i + j] = std::uint32_t(diff);
+          borrow = std::int64_t(product >> 32) - (diff >> 32);
+        }
+        std::int64_t top = std::int64_t(u[j + n]) - borrow;
+        u[j + n] = std::uint32_t(top);
+        if(top < 0) { //q_hat was one too large; add the divisor back
+          --q_hat;
+          std::uint64_t carry = 0;
+          for(std::size_t i = 0; i < n; ++i) {
+            std::uint64_t sum = std::uint64_t(u[i + j]) + v[i] + carry;
+            u[i + j] = std::uint32_t(sum);
+            carry = sum >> 32;
+          }
+          u[j + n] += std::uint32_t(carry);
+        }
+        quotient[j] = std::uint32_t(q_hat);
+      }
+      Magnitude remainder(n);
+      for(std::size_t i = 0; i < n; ++i) {
+        remainder[i] = (u[i] >> shift) | (shift ? u[i + 1] << (32 - shift) : 0);
+      }
+      trim(quotient);
+      trim(remainder);
+      return {std::move(quotient), std::move(remainder)};
+    }
+  }
+  BigInt::BigInt(std::vector<std::uint32_t> value, bool negative) {
+    trim(value);
+    if(!value.empty()) {
+      limbs = std::make_shared<Magnitude const>(std::move(value));
+      this->negative = negative;
+    }
+  }
+  BigInt::BigInt(std::uint64_t value):BigInt(Magnitude{std::uint32_t(value), std::uint32_t(value >> 32)}, false) {}
+  std::vector<std::uint32_t> const& BigInt::magnitude() const {
+    static Magnitude const zero;
+    return limbs ? *limbs : zero;
+  }
+  std::optional<BigInt> BigInt::parse(std::string_view str) {
+    bool negative = str.starts_with('-');
+    if(negative) str.remove_prefix(1);
+    if(str.empty() || !std::all_of(str.begin(), str.end(), [](char c) { return '0' <= c && c <= '9'; })) return std::nullopt;
+    Magnitude value;
+    auto first_chunk = str.size() % 9 == 0 ? 9 : str.size() % 9;
+    for(std::size_t position = 0; position < str.size();) {
+      auto chunk_size = position == 0 ? first_chunk : 9;
+      std::uint32_t chunk = 0;
+      std::uint32_t scale = 1;
+      for(std::size_t i = 0; i < chunk_size; ++i) {
+        chunk = chunk * 10 + (str[position + i] - '0');
+        scale *= 10;
+      }
+      position += chunk_size;
+      std::uint64_t carry = chunk;
+      for(auto& limb : value) {
+        std::uint64_t product = std::uint64_t(limb) * scale + carry;
+        limb = std::uint32_t(product);
+        carry = product >> 32;
+      }
+      if(carry) value.push_back(std::uint32_t(carry));
+    }
+    return BigInt{std::move(value), negative};
+  }
+  bool BigInt::is_zero() const {
+    return !limbs;
+  }
+  bool BigInt::is_negative() const {
+    return negative;
+  }
+  std::optional<std::uint64_t> BigInt::to_u64() const {
+    auto const& value = magnitude();
+    if(negative || value.size() > 2) return std::nullopt;
+    std::uint64_t ret = 0;
+    for(std::size_t i = value.size(); i-- > 0;) {
+      ret = (ret << 32) | value[i];
+    }
+    return ret;
+  }
+  std::string BigInt::to_string() const {
+    if(is_zero()) return "0";
+    auto value = magnitude();
+    std::vector<std::uint32_t> chunks; //base 10^9, least significant first
+    while(!value.empty()) {
+      chunks.push_back(divide_by_limb(value, decimal_chunk));
+    }
+    std::string ret = negative ? "-" : "";
+    ret += std::to_string(chunks.back());
+    for(std::size_t i = chunks.size() - 1; i-- > 0;) {
+      auto digits = std::to_string(chunks[i]);
+      ret.append(9 - digits.size(), '0');
+      ret += digits;
+    }
+    return ret;
+  }
+  BigInt BigInt::operator-() const {
+    BigInt ret = *this;
+    if(!ret.is_zero()) ret.negative = !ret.negative;
+    return ret;
+  }
+  BigInt operator+(BigInt const& lhs, BigInt const& rhs) {
+    if(lhs.negative == rhs.negative) {
+      return BigInt{add_magnitude(lhs.magnitude(), rhs.magnitude()), lhs.negative};
+    }
+    if(compare_magnitude(lhs.magnitude(), rhs.magnitude()) >= 0) {
+      return BigInt{sub_magnitude(lhs.magnitude(), rhs.magnitude()), lhs.negative};
+    } else {
+      return BigInt{sub_magnitude(rhs.magnitude(), lhs.magnitude()), rhs.negative};
+    }
+  }
+  BigInt operator-(BigInt const& lhs, BigInt const& rhs) {
+    return lhs + -rhs;
+  }
+  BigInt operator*(BigInt const& lhs, BigInt const& rhs) {
+    return BigInt{multiply_magnitude(lhs.magnitude(), rhs.magnitude()), lhs.negative != rhs.negative};
+  }
+  std::pair<BigInt, BigInt> divmod(BigInt const& lhs, BigInt const& rhs) {
+    if(rhs.is_zero()) return {BigInt{}, lhs};
+    auto [quotient, remainder] = divide_magnitude(lhs.magnitude(), rhs.magnitude());
+    return {
+      BigInt{std::move(quotient), lhs.negative != rhs.negative},
+      BigInt{std::move(remainder), lhs.negative}
+    };
+  }
+  BigInt pow(BigInt const& base, std::uint64_t exponent) {
+    BigInt ret{1};
+    BigInt square = base;
+    while(exponent) {
+      if(exponent & 1) ret = ret * square;
+      exponent >>= 1;
+      if(exponent) square = square * square;
+    }
+    return ret;
+  }
+  std::strong_ordering operator<=>(BigInt const& lhs, BigInt const& rhs) {
+    if(lhs.negative != rhs.negative) return lhs.negative ? std::strong_ordering::less : std::strong_ordering::greater;
+    auto ret = compare_magnitude(lhs.magnitude(), rhs.magnitude());
+    return lhs.negative ? 0 <=> ret : ret;
+  }
+  bool operator==(BigInt const& lhs, BigInt const& rhs) {
+    return lhs.negative == rhs.negative && (lhs.limbs == rhs.limbs || lhs.magnitude() == rhs.magnitude());
+  }
+  std::ostream& operator<<(std::ostream& o, BigInt const& value) {
+    return o << value.to_string() << "n";
+  }
+}
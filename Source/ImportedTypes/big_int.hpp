@@ -0,0 +1,44 @@
+#ifndef BIG_INT_HPP
+#define BIG_INT_HPP
+
+#include <compare>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace imported_type {
+  /*
+    An arbitrary-precision signed integer. The magnitude is stored as
+    little-endian 32-bit limbs without leading zeros, shared between copies
+    since values are never modified in place.
+  */
+  class BigInt {
+    std::shared_ptr<std::vector<std::uint32_t> const> limbs; //null for zero
+    bool negative = false;
+    BigInt(std::vector<std::uint32_t> magnitude, bool negative);
+    std::vector<std::uint32_t> const& magnitude() const;
+  public:
+    BigInt() = default;
+    BigInt(std::uint64_t);
+    static std::optional<BigInt> parse(std::string_view); //decimal digits, optionally preceded by '-'
+    bool is_zero() const;
+    bool is_negative() const;
+    std::optional<std::uint64_t> to_u64() const; //if it fits
+    std::string to_string() const;
+    BigInt operator-() const;
+    friend BigInt operator+(BigInt const&, BigInt const&);
+    friend BigInt operator-(BigInt const&, BigInt const&);
+    friend BigInt operator*(BigInt const&, BigInt const&);
+    friend std::pair<BigInt, BigInt> divmod(BigInt const&, BigInt const&); //truncates towards zero; x / 0 = 0 and x % 0 = x
+    friend BigInt pow(BigInt const&, std::uint64_t);
+    friend std::strong_ordering operator<=>(BigInt const&, BigInt const&);
+    friend bool operator==(BigInt const&, BigInt const&);
+  };
+  std::ostream& operator<<(std::ostream&, BigInt const&);
+}
+
+#endif
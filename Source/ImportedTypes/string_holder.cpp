@@ -1,83 +1,243 @@
 #include "string_holder.hpp"
+#include <algorithm>
 #include <atomic>
 #include <cstring>
 
 namespace imported_type {
   namespace {
-    constexpr auto counter_size = sizeof(std::atomic<std::uint64_t>);
-    std::atomic<std::uint64_t>& counter_for(std::byte* data) {
-      return *(std::atomic<std::uint64_t>*)data;
+    constexpr std::uint64_t merge_size = 128; //joins and slices at most this long are copied into a single leaf
+  }
+  /*
+    Ropes are AVL-balanced trees of concatenations over contiguous leaves.
+    Nodes are never modified after construction, except that a concatenation
+    may cache its flattened characters. The cache is published with a single
+    atomic exchange, so shared nodes may be flattened from several threads;
+    the shape of the tree, heights included, never changes.
+  */
+  struct StringHolder::Node {
+    enum class Kind : std::uint8_t {
+      leaf, //characters stored after the node
+      slice, //characters borrowed from the node in left
+      concat //left followed by right; flat caches the characters once flattened
+    };
+    std::atomic<std::uint64_t> count;
+    Kind kind;
+    std::uint8_t height; //0 for everything but concatenations
+    std::uint64_t size;
+    Node* left;
+    Node* right;
+    std::atomic<char const*> flat; //null for a concatenation not yet flattened
+    Node(Kind kind, std::uint8_t height, std::uint64_t size, Node* left, Node* right, char const* flat):count(1),kind(kind),height(height),size(size),left(left),right(right),flat(flat) {}
+
+    static void ref(Node* node) {
+      ++node->count;
     }
-    void unref_data(std::byte* data) {
-      if(--counter_for(data) == 0) {
-        using T = std::atomic<std::uint64_t>;
-        counter_for(data).~T();
-        free(data);
+    static void unref(Node* node) {
+      if(--node->count == 0) {
+        switch(node->kind) {
+          case Kind::leaf: break;
+          case Kind::slice: unref(node->left); break;
+          case Kind::concat: free((void*)node->flat.load()); unref(node->left); unref(node->right); break;
+        }
+        node->~Node();
+        free(node);
       }
     }
-    void ref_data(std::byte* data) {
-      ++counter_for(data);
+    static void write_to(Node const* node, char* target) {
+      if(auto* chars = node->flat.load(std::memory_order_acquire)) {
+        std::memcpy(target, chars, node->size);
+      } else {
+        write_to(node->left, target);
+        write_to(node->right, target + node->left->size);
+      }
     }
+    static Node* make_leaf(std::uint64_t size, auto&& write) {
+      auto* memory = (Node*)malloc(sizeof(Node) + size + 1);
+      auto* chars = (char*)(memory + 1);
+      write(chars);
+      chars[size] = 0; //null terminator
+      return new (memory) Node{Kind::leaf, 0, size, nullptr, nullptr, chars};
+    }
+    static Node* make_leaf(std::string_view str) {
+      return make_leaf(str.size(), [&](char* target) { std::memcpy(target, str.data(), str.size()); });
+    }
+    static Node* make_concat(Node* lhs, Node* rhs) { //takes ownership of both
+      return new (malloc(sizeof(Node))) Node{Kind::concat, (std::uint8_t)(1 + std::max(lhs->height, rhs->height)), lhs->size + rhs->size, lhs, rhs, nullptr};
+    }
+    static char const* flatten(Node* node) {
+      auto* cached = node->flat.load(std::memory_order_acquire);
+      if(cached) return cached;
+      auto* chars = (char*)malloc(node->size + 1);
+      write_to(node, chars);
+      chars[node->size] = 0;
+      if(node->flat.compare_exchange_strong(cached, chars, std::memory_order_acq_rel, std::memory_order_acquire)) {
+        return chars;
+      }
+      free(chars); //another thread flattened it first
+      return cached;
+    }
+    static Node* balance(Node* lhs, Node* rhs) { //takes ownership of both; heights may differ by at most 2
+      if(lhs->height > rhs->height + 1) {
+        auto* outer = lhs->left;
+        auto* inner = lhs->right;
+        ref(outer);
+        ref(inner);
+        unref(lhs);
+        if(outer->height >= inner->height) {
+          return make_concat(outer, make_concat(inner, rhs));
+        }
+        auto* inner_left = inner->left;
+        auto* inner_right = inner->right;
+        ref(inner_left);
+        ref(inner_right);
+        unref(inner);
+        return make_concat(make_concat(outer, inner_left), make_concat(inner_right, rhs));
+      }
+      if(rhs->height > lhs->height + 1) {
+        auto* inner = rhs->left;
+        auto* outer = rhs->right;
+        ref(inner);
+        ref(outer);
+        unref(rhs);
+        if(outer->height >= inner->height) {
+          return make_concat(make_concat(lhs, inner), outer);
+        }
+        auto* inner_left = inner->left;
+        auto* inner_right = inner->right;
+        ref(inner_left);
+        ref(inner_right);
+        unref(inner);
+        return make_concat(make_concat(lhs, inner_left), make_concat(inner_right, outer));
+      }
+      return make_concat(lhs, rhs);
+    }
+    static Node* join(Node* lhs, Node* rhs) { //takes ownership of both
+      if(lhs->size == 0) { unref(lhs); return rhs; }
+      if(rhs->size == 0) { unref(rhs); return lhs; }
+      if(lhs->size + rhs->size <= merge_size) {
+        auto* ret = make_leaf(lhs->size + rhs->size, [&](char* target) {
+          write_to(lhs, target);
+          write_to(rhs, target + lhs->size);
+        });
+        unref(lhs);
+        unref(rhs);
+        return ret;
+      }
+      if(lhs->height > rhs->height + 1) {
+        auto* left = lhs->left;
+        auto* right = lhs->right;
+        ref(left);
+        ref(right);
+        unref(lhs);
+        return balance(left, join(right, rhs));
+      }
+      if(rhs->height > lhs->height + 1) {
+        auto* left = rhs->left;
+        auto* right = rhs->right;
+        ref(left);
+        ref(right);
+        unref(rhs);
+        return balance(join(lhs, left), right);
+      }
+      return make_concat(lhs, rhs);
+    }
+    static Node* slice(Node* node, std::uint64_t start, std::uint64_t length) { //returns a new reference
+      if(start == 0 && length == node->size) {
+        ref(node);
+        return node;
+      }
+      if(node->kind != Kind::concat) {
+        if(length <= merge_size) return make_leaf(std::string_view{node->flat.load() + start, length});
+        auto* owner = node->kind == Kind::slice ? node->left : node;
+        ref(owner);
+        return new (malloc(sizeof(Node))) Node{Kind::slice, 0, length, owner, nullptr, node->flat.load() + start};
+      }
+      auto left_size = node->left->size;
+      if(start + length <= left_size) return slice(node->left, start, length);
+      if(start >= left_size) return slice(node->right, start - left_size, length);
+      return join(
+        slice(node->left, start, left_size - start),
+        slice(node->right, 0, start + length - left_size)
+      );
+    }
+  };
+  StringHolder::StringHolder(Node* node, std::uint64_t start, std::uint64_t length):node(node),start(start),length(length) {}
+  StringHolder::StringHolder(std::string_view str):node(Node::make_leaf(str)),start(0),length(str.size()) {}
+  StringHolder::StringHolder(StringHolder const& other):node(other.node),start(other.start),length(other.length) {
+    if(node) Node::ref(node);
   }
-  StringHolder::StringHolder(std::byte* allocation, const char* m_begin, const char* m_end):allocation(allocation),m_begin(m_begin),m_end(m_end) {}
-  StringHolder::StringHolder(std::string_view str) {
-    allocation = (std::byte*)malloc(counter_size + str.size() + 1);
-    new (allocation) std::atomic<std::uint64_t>{1};
-    std::memcpy(allocation + counter_size, str.data(), str.size());
-    allocation[counter_size + str.size()] = (std::byte)0; //null terminator
-    m_begin = (const char*)(allocation + counter_size);
-    m_end = (const char*)(allocation + counter_size + str.size());
-  }
-  StringHolder::StringHolder(StringHolder const& other):allocation(other.allocation),m_begin(other.m_begin),m_end(other.m_end) {
-    if(allocation) ref_data(allocation);
-  }
-  StringHolder::StringHolder(StringHolder&& other):allocation(other.allocation),m_begin(other.m_begin),m_end(other.m_end) {
-    other.allocation = nullptr;
+  StringHolder::StringHolder(StringHolder&& other):node(other.node),start(other.start),length(other.length) {
+    other.node = nullptr;
   }
   StringHolder& StringHolder::operator=(StringHolder const& other) {
-    auto prior = allocation;
-    allocation = other.allocation;
-    m_begin = other.m_begin;
-    m_end = other.m_end;
-    if(allocation) ref_data(allocation);
-    if(prior) unref_data(prior);
+    auto prior = node;
+    node = other.node;
+    start = other.start;
+    length = other.length;
+    if(node) Node::ref(node);
+    if(prior) Node::unref(prior);
     return *this;
   }
   StringHolder& StringHolder::operator=(StringHolder&& other) {
-    auto prior = allocation;
-    allocation = other.allocation;
-    m_begin = other.m_begin;
-    m_end = other.m_end;
-    other.allocation = nullptr;
-    if(prior) unref_data(prior);
+    auto prior = node;
+    node = other.node;
+    start = other.start;
+    length = other.length;
+    other.node = nullptr;
+    if(prior) Node::unref(prior);
     return *this;
   }
   StringHolder::~StringHolder() {
-    if(allocation) unref_data(allocation);
+    if(node) Node::unref(node);
   }
   std::size_t StringHolder::size() const {
-    return m_end - m_begin;
+    return length;
   }
   StringHolder StringHolder::substr(std::uint64_t start, std::uint64_t len) && {
-    auto a = allocation;
-    allocation = nullptr;
+    start = std::min(start, length);
+    len = std::min(len, length - start);
+    auto n = node;
+    node = nullptr;
     return StringHolder{
-      a,
-      m_begin + start,
-      m_begin + start + len
+      n,
+      this->start + start,
+      len
     };
   }
   StringHolder StringHolder::substr(std::uint64_t start, std::uint64_t len) const& {
     return StringHolder{*this}.substr(start, len); //copy and then substr
   }
   StringHolder StringHolder::substr(std::uint64_t start) && {
-    return std::move(*this).substr(start, size() - start);
+    return std::move(*this).substr(start, size() - std::min(start, size()));
   }
   StringHolder StringHolder::substr(std::uint64_t start) const& {
-    return substr(start, size() - start);
+    return substr(start, size() - std::min(start, size()));
   }
   std::string_view StringHolder::get_string() const {
-    return std::string_view{m_begin, size()};
+    //Only flatten the smallest subtree containing the view.
+    auto* current = node;
+    auto offset = start;
+    while(current->kind == Node::Kind::concat) {
+      auto left_size = current->left->size;
+      if(offset + length <= left_size) {
+        current = current->left;
+      } else if(offset >= left_size) {
+        offset -= left_size;
+        current = current->right;
+      } else {
+        break;
+      }
+    }
+    return std::string_view{Node::flatten(current) + offset, length};
+  }
+  StringHolder operator+(StringHolder const& lhs, StringHolder const& rhs) {
+    if(lhs.length == 0) return rhs;
+    if(rhs.length == 0) return lhs;
+    auto* joined = StringHolder::Node::join(
+      StringHolder::Node::slice(lhs.node, lhs.start, lhs.length),
+      StringHolder::Node::slice(rhs.node, rhs.start, rhs.length)
+    );
+    return StringHolder{joined, 0, joined->size};
   }
   bool operator==(StringHolder const& lhs, StringHolder const& rhs) {
     return lhs.get_string() == rhs.get_string();
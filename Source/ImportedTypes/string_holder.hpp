@@ -3,14 +3,24 @@
 
 #include <string>
 #include <cstddef>
+#include <cstdint>
 #include <iostream>
 
 namespace imported_type {
+  /*
+    An immutable string, stored as a view into a shared rope. Concatenation
+    joins balanced trees in logarithmic time and substr only adjusts the view.
+    Contiguous characters are produced lazily by get_string(), which flattens
+    the smallest subtree covering the view and caches the result there. The
+    cache is set atomically, so get_string() is safe on strings shared
+    between threads.
+  */
   class StringHolder {
-    std::byte* allocation;
-    const char* m_begin;
-    const char* m_end;
-    StringHolder(std::byte*, const char*, const char*);
+    struct Node;
+    Node* node;
+    std::uint64_t start;
+    std::uint64_t length;
+    StringHolder(Node*, std::uint64_t start, std::uint64_t length);
   public:
     StringHolder(std::string_view);
     StringHolder(StringHolder const&);
@@ -19,11 +29,12 @@ namespace imported_type {
     StringHolder& operator=(StringHolder&&);
     ~StringHolder();
     std::size_t size() const;
-    StringHolder substr(std::uint64_t start, std::uint64_t len) &&;
+    StringHolder substr(std::uint64_t start, std::uint64_t len) &&; //clamped to the string
     StringHolder substr(std::uint64_t start, std::uint64_t len) const&;
     StringHolder substr(std::uint64_t start) &&;
     StringHolder substr(std::uint64_t start) const&;
     std::string_view get_string() const;
+    friend StringHolder operator+(StringHolder const&, StringHolder const&);
   };
   bool operator==(StringHolder const&, StringHolder const&);
   std::ostream& operator<<(std::ostream&, StringHolder const&);
@@ -0,0 +1,30 @@
+#include <catch.hpp>
+#include "../ImportedTypes/big_int.hpp"
+
+using imported_type::BigInt;
+
+TEST_CASE("BigInt round-trips decimal and handles signs.") {
+  auto value = *BigInt::parse("-123456789012345678901234567890");
+  REQUIRE(value.to_string() == "-123456789012345678901234567890");
+  REQUIRE((value + -value).is_zero());
+  REQUIRE((BigInt{5} - BigInt{12}).to_string() == "-7");
+  REQUIRE(BigInt{18446744073709551615ull}.to_u64() == 18446744073709551615ull);
+  REQUIRE(!(BigInt{18446744073709551615ull} + BigInt{1}).to_u64());
+  REQUIRE(!BigInt::parse("12a"));
+  auto [quotient, remainder] = divmod(BigInt{7}, -BigInt{2});
+  REQUIRE(quotient == -BigInt{3});
+  REQUIRE(remainder == BigInt{1});
+  REQUIRE(divmod(BigInt{7}, BigInt{}).first.is_zero());
+  REQUIRE(divmod(BigInt{7}, BigInt{}).second == BigInt{7});
+}
+TEST_CASE("BigInt multiplies and divides numbers large enough for Karatsuba.") {
+  auto lhs = pow(BigInt{3}, 2000);
+  auto rhs = pow(BigInt{7}, 1000) + BigInt{12345};
+  auto product = lhs * rhs;
+  auto [quotient, remainder] = divmod(product + BigInt{11}, rhs);
+  REQUIRE(quotient == lhs);
+  REQUIRE(remainder == BigInt{11});
+  REQUIRE(divmod(lhs, rhs).first * rhs + divmod(lhs, rhs).second == lhs);
+  REQUIRE(lhs > rhs);
+  REQUIRE(-lhs < -rhs);
+}
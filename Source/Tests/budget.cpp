@@ -0,0 +1,86 @@
+#include <catch.hpp>
+#include <sstream>
+#include "test_utility.hpp"
+
+namespace {
+  constexpr auto looping_definitions = R"#--#(
+block {
+  axiom Nat : Type;
+  axiom zero : Nat;
+  axiom succ : Nat -> Nat;
+  axiom Hold : Type; # keeps the rules from looping while they are simplified
+  axiom unhold : Hold;
+  declare Loop : Hold -> Hold -> Nat -> Type;
+  Loop h unhold n = Loop h h (succ n);
+  declare grow : Hold -> Hold -> Nat -> Nat;
+  grow h unhold n = grow h h (succ n);
+  axiom Is : Hold -> Type; # only the solver learns that a hole is unhold
+  axiom is_unhold : Is unhold;
+  zero
+}
+)#--#";
+}
+
+TEST_CASE("Compilations which run out of budget are undone and report why.") {
+  auto environment = setup_enviroment();
+  std::stringstream output;
+  environment.debug_parse(looping_definitions, output);
+  INFO(output.str());
+  auto externals_before = environment.context().external_info.size();
+  auto rules_before = environment.context().rules.size();
+
+  SECTION("A step limit stops a non-terminating solve.") {
+    expression::Budget budget{{.steps = 10000}};
+    auto result = environment.parse("block { declare x : Loop unhold unhold zero; let y : Nat = x; y }", budget);
+    REQUIRE(!result.has_result());
+    REQUIRE(result.get_budget_exceeded());
+    REQUIRE(result.get_budget_exceeded()->reason == expression::BudgetExceeded::Reason::steps);
+  }
+  SECTION("A budget can run out part way through solving.") {
+    expression::Budget budget{{.steps = 10000}};
+    auto result = environment.parse("block { declare k : (h : Hold) -> Is h -> Loop unhold h zero; let y : Nat = k _ is_unhold; y }", budget);
+    REQUIRE(result.get_budget_exceeded());
+    REQUIRE(result.get_budget_exceeded()->reason == expression::BudgetExceeded::Reason::steps);
+    REQUIRE(result.get_stats().solve.equations > 0); //partial counts survive the failure
+    REQUIRE(result.get_stats().solver.examinations > 0);
+  }
+  SECTION("A node limit stops a non-terminating solve.") {
+    expression::Budget budget{{.nodes = 100000}};
+    auto result = environment.parse("block { declare x : Loop unhold unhold zero; let y : Nat = x; y }", budget);
+    REQUIRE(result.get_budget_exceeded());
+    REQUIRE(result.get_budget_exceeded()->reason == expression::BudgetExceeded::Reason::nodes);
+  }
+  SECTION("A cancelled budget stops work at the next step.") {
+    expression::Budget budget;
+    budget.cancel();
+    auto result = environment.parse("block { declare x : Loop unhold unhold zero; let y : Nat = x; y }", budget);
+    REQUIRE(result.get_budget_exceeded());
+    REQUIRE(result.get_budget_exceeded()->reason == expression::BudgetExceeded::Reason::cancelled);
+  }
+  SECTION("Printing a non-terminating result is stopped too.") {
+    expression::Budget budget{{.steps = 10000}};
+    std::stringstream budgeted_output;
+    environment.debug_parse("grow unhold unhold zero", budgeted_output, budget);
+    REQUIRE(budgeted_output.str().find("Budget exceeded") != std::string::npos);
+  }
+  REQUIRE(environment.context().external_info.size() == externals_before);
+  REQUIRE(environment.context().rules.size() == rules_before);
+  auto expr_full = environment.parse("succ (succ zero)");
+  REQUIRE(expr_full.is_fully_solved());
+}
+TEST_CASE("Reductions can be given a budget directly.") {
+  auto environment = setup_enviroment();
+  std::stringstream output;
+  environment.debug_parse(looping_definitions, output);
+  INFO(output.str());
+  auto looping = environment.parse("grow unhold unhold zero");
+  REQUIRE(looping.is_fully_solved());
+  expression::Budget budget{{.steps = 1000}};
+  REQUIRE_THROWS_AS(environment.context().reduce(looping.get_result().value, budget), expression::BudgetExceeded);
+  REQUIRE(budget.steps_used() > 1000);
+  REQUIRE(environment.context().budget == nullptr);
+
+  auto finite = environment.parse("succ zero");
+  expression::Budget enough{{.steps = 1000}};
+  REQUIRE(environment.context().reduce(finite.get_result().value, enough) == environment.context().reduce(finite.get_result().value));
+}
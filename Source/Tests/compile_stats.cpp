@@ -0,0 +1,88 @@
+#include <catch.hpp>
+#include <sstream>
+#include "test_utility.hpp"
+
+TEST_CASE("Parse results record the work done in each phase.") {
+  auto environment = setup_enviroment();
+  auto result = environment.parse(nat_double_block("double (succ zero)"));
+  REQUIRE(result.is_fully_solved());
+  auto const& stats = result.get_stats();
+  REQUIRE(stats.lex.output_nodes > 0);
+  REQUIRE(stats.read.output_nodes > 0);
+  REQUIRE(stats.resolve.output_nodes > 0);
+  REQUIRE(stats.instructions.output_nodes > 0);
+  REQUIRE(stats.evaluate.externals_created >= 4); //at least the declared names
+  REQUIRE(stats.evaluate.casts > 0);
+  REQUIRE(stats.solve.equations > 0);
+  REQUIRE(stats.evaluate.rules_created + stats.solve.rules_created >= 2);
+  REQUIRE(stats.simplify.time == std::chrono::steady_clock::duration{}); //only run by debug_parse
+  REQUIRE(environment.get_last_stats().solve.equations == stats.solve.equations);
+
+  std::stringstream table;
+  table << stats;
+  REQUIRE(table.str().find("solve") != std::string::npos);
+  REQUIRE(table.str().find("deepen") != std::string::npos);
+}
+TEST_CASE("Solver stats count the rules applied to each equation.") {
+  auto environment = setup_enviroment();
+  auto result = environment.parse(nat_double_block(R"#--#(
+  let f : Nat -> Nat = \x:Nat.succ x;
+  f (double (succ zero))
+)#--#"));
+  REQUIRE(result.is_fully_solved());
+  auto const& solver = result.get_stats().solver;
+  auto all = {solver.extract_rule, solver.deepen, solver.explode_symmetric, solver.explode_asymmetric, solver.judge_equal};
+  std::uint64_t handled = 0;
+  for(auto const& counts : all) {
+    REQUIRE(counts.attempts == counts.handled + counts.failed + counts.misses());
+    REQUIRE(counts.failed == 0);
+    handled += counts.handled;
+  }
+  REQUIRE(handled == solver.equations_resolved);
+  REQUIRE(solver.equations_resolved == result.get_stats().solve.equations); //all solved
+  REQUIRE(solver.extract_rule.attempts == solver.examinations); //tried first
+  REQUIRE(solver.examinations_to_resolve <= solver.examinations);
+  REQUIRE(solver.max_examinations >= 1);
+  REQUIRE(solver.deepen.handled >= 1); //the let's lambda against its declared type
+  REQUIRE(solver.max_deepening_depth >= 1);
+}
+TEST_CASE("Solver stats count refutations.") {
+  auto environment = setup_enviroment();
+  auto result = environment.parse(R"#--#(
+block {
+  axiom Nat : Type;
+  axiom Bool : Type;
+  axiom zero : Nat;
+  axiom f : Bool -> Bool;
+  f zero
+}
+)#--#");
+  REQUIRE(!result.is_fully_solved());
+  auto const& solver = result.get_stats().solver;
+  REQUIRE(solver.explode_symmetric.failed + solver.explode_asymmetric.failed >= 1);
+}
+TEST_CASE("Phases after a failing one are left empty.") {
+  auto environment = setup_enviroment();
+  auto result = environment.parse("block { declare x : ; x }");
+  REQUIRE(!result.has_result());
+  auto const& stats = result.get_stats();
+  REQUIRE(stats.lex.output_nodes > 0);
+  REQUIRE(stats.read.output_nodes == 0);
+  REQUIRE(stats.evaluate.externals_created == 0);
+  REQUIRE(stats.solve.equations == 0);
+}
+TEST_CASE("debug_parse writes the stats, solver counts included, when asked to.") {
+  auto environment = setup_enviroment();
+  std::stringstream quiet;
+  environment.debug_parse(nat_double_block("double (succ zero)"), quiet);
+  REQUIRE(quiet.str().find("Solver rule") == std::string::npos);
+
+  environment.set_print_stats(true);
+  std::stringstream output;
+  environment.debug_parse(nat_double_block("double (succ zero)"), output);
+  std::stringstream expected;
+  expected << environment.get_last_stats();
+  REQUIRE(output.str().find("of type") != std::string::npos);
+  REQUIRE(output.str().ends_with(expected.str()));
+  REQUIRE(expected.str().find("Solver rule") != std::string::npos);
+}
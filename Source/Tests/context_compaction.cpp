@@ -0,0 +1,53 @@
+#include <catch.hpp>
+#include <sstream>
+#include "test_utility.hpp"
+
+TEST_CASE("Compacting the environment discards temporaries but keeps named values working.") {
+  auto environment = setup_enviroment();
+  std::stringstream output;
+  environment.debug_parse(nat_double_block(R"#--#(
+  let four = double (succ (succ zero));
+  four
+)#--#"), output);
+  auto before = environment.context().external_info.size();
+  environment.compact();
+  auto after = environment.context().external_info.size();
+  INFO(output.str());
+  REQUIRE(after < before);
+
+  auto expr_full = environment.parse("double four");
+  auto expect_full = environment.parse("succ (succ (succ (succ (succ (succ (succ (succ zero)))))))");
+  REQUIRE(expr_full.is_fully_solved());
+  REQUIRE(expect_full.is_fully_solved());
+  REQUIRE(expr_full.get_reduced_result() == expect_full.get_reduced_result());
+}
+TEST_CASE("Compacting after binding a packed_nat keeps the naturals packed and discards temporaries.") {
+  auto environment = setup_enviroment();
+  std::stringstream output;
+  environment.debug_parse(R"#--#(
+block {
+  axiom Nat : Type;
+  axiom zero : Nat;
+  axiom succ : Nat -> Nat;
+  pragma packed_nat zero succ;
+  declare double : Nat -> Nat;
+  double zero = zero;
+  double (succ n) = succ (succ (double n));
+  let four = double (succ (succ zero));
+  four
+}
+)#--#", output);
+  INFO(output.str());
+  auto before = environment.context().external_info.size();
+  auto data_rules_before = environment.context().data_rules.size();
+  environment.compact();
+  REQUIRE(environment.context().external_info.size() < before);
+  REQUIRE(environment.context().data_rules.size() == data_rules_before);
+
+  auto expr_full = environment.parse("double four");
+  auto expect_full = environment.parse("succ (succ (succ (succ (succ (succ (succ (succ zero)))))))");
+  REQUIRE(expr_full.is_fully_solved());
+  REQUIRE(expect_full.is_fully_solved());
+  REQUIRE(expr_full.get_reduced_result() == expect_full.get_reduced_result());
+  REQUIRE(expr_full.get_reduced_result().value.holds_data()); //still packed
+}
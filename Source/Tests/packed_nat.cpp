@@ -0,0 +1,45 @@
+#include <catch.hpp>
+#include <sstream>
+#include "test_utility.hpp"
+
+namespace {
+  constexpr auto packed_definitions = R"#--#(
+  axiom N : Type;
+  axiom z : N;
+  axiom s : N -> N;
+  pragma packed_nat z s;
+)#--#";
+  std::uint64_t packed_type_index(expression::interactive::ParseResult const& result) {
+    return result.get_reduced_result().value.get_data().data.get_type_index();
+  }
+}
+
+TEST_CASE("Long packed naturals are printed without deep recursion.") {
+  auto environment = setup_enviroment();
+  std::stringstream output;
+  environment.debug_parse(std::string{"block {"} + packed_definitions + "iterate_strict N s z 20000 }", output);
+  auto str = output.str();
+  REQUIRE(str.find("s (s (s (") != std::string::npos);
+  REQUIRE(str.find(std::string(19999, ')') + " of type") != std::string::npos); //the outermost succ is not parenthesized
+}
+TEST_CASE("Packed naturals undone by a failed compilation give their type to the next.") {
+  auto environment = setup_enviroment();
+  auto first = environment.parse(std::string{"block {"} + packed_definitions + "s z }");
+  REQUIRE(first.is_fully_solved());
+  for(int i = 0; i < 2; ++i) { //printing the result runs out of budget, undoing the compilation
+    expression::Budget budget{{.steps = 10000}};
+    std::stringstream output;
+    environment.debug_parse(std::string{"block {"} + packed_definitions + R"#--#(
+  axiom Hold : Type;
+  axiom unhold : Hold;
+  declare grow : Hold -> Hold -> N -> N;
+  grow h unhold n = grow h h (s n);
+  grow unhold unhold z
+}
+)#--#", output, budget);
+    REQUIRE(output.str().find("Budget exceeded") != std::string::npos);
+  }
+  auto second = environment.parse(std::string{"block {"} + packed_definitions + "s z }");
+  REQUIRE(second.is_fully_solved());
+  REQUIRE(packed_type_index(second) == packed_type_index(first) + 1); //one type for both failures and the rebinding
+}
@@ -0,0 +1,39 @@
+#include <catch.hpp>
+#include <sstream>
+#include "test_utility.hpp"
+
+TEST_CASE("The reduction profile counts rule firings and follows compaction.") {
+  auto environment = setup_enviroment();
+  environment.context().profile.emplace();
+  std::stringstream output;
+  environment.debug_parse(nat_double_block(R"#--#(
+  let four = double (succ (succ zero));
+  four
+)#--#"), output);
+  INFO(output.str());
+  auto fired = [&] { //by the rules for double zero and double (succ n)
+    auto double_head = environment.parse("double").get_result().value.get_external().external_index; //renumbered by compaction
+    std::uint64_t zero_case = 0;
+    std::uint64_t succ_case = 0;
+    auto const& profile = *environment.context().profile;
+    for(auto const& hot : profile.hottest_rules(-1)) {
+      if(hot.is_data) continue;
+      auto const& rule = environment.context().rules[hot.rule];
+      if(expression::get_pattern_head(rule.pattern) != double_head) continue;
+      (rule.pattern.get_apply().rhs.holds_apply() ? succ_case : zero_case) += hot.counts.firings;
+    }
+    return std::make_pair(zero_case, succ_case);
+  };
+  auto [zero_before, succ_before] = fired();
+  REQUIRE(zero_before >= 1);
+  REQUIRE(succ_before >= 2);
+
+  std::stringstream report;
+  environment.print_profile(report, 10);
+  REQUIRE(report.str().find("double") != std::string::npos);
+
+  environment.compact(); //renumbers the rules, and reduces four again
+  auto [zero_after, succ_after] = fired();
+  REQUIRE(zero_after >= zero_before);
+  REQUIRE(succ_after >= succ_before);
+}
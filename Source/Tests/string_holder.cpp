@@ -0,0 +1,78 @@
+#include <catch.hpp>
+#include "../ImportedTypes/string_holder.hpp"
+#include <random>
+
+using imported_type::StringHolder;
+
+TEST_CASE("StringHolder concatenation and substr agree with std::string.") {
+  std::mt19937_64 random{17};
+  std::vector<StringHolder> holders{StringHolder{""}, StringHolder{"a"}};
+  std::vector<std::string> strings{"", "a"};
+  for(std::size_t step = 0; step < 2000; ++step) {
+    auto i = random() % holders.size();
+    auto j = random() % holders.size();
+    switch(random() % 3) {
+      case 0: {
+        auto piece = std::string(random() % 200, (char)('a' + random() % 26));
+        holders.push_back(holders[i] + StringHolder{piece});
+        strings.push_back(strings[i] + piece);
+        break;
+      }
+      case 1:
+        holders.push_back(holders[i] + holders[j]);
+        strings.push_back(strings[i] + strings[j]);
+        break;
+      case 2: {
+        auto start = random() % (strings[i].size() + 1);
+        auto length = random() % (strings[i].size() - start + 1);
+        holders.push_back(holders[i].substr(start, length));
+        strings.push_back(strings[i].substr(start, length));
+        break;
+      }
+    }
+    if(strings.back().size() > 100000) { //keep the test fast
+      holders.pop_back();
+      strings.pop_back();
+    }
+  }
+  for(std::size_t i = 0; i < holders.size(); ++i) {
+    REQUIRE(holders[i].size() == strings[i].size());
+    REQUIRE(holders[i].get_string() == strings[i]);
+  }
+}
+TEST_CASE("StringHolder accumulates long strings one piece at a time.") {
+  StringHolder accumulated{""};
+  std::string expected;
+  for(std::size_t i = 0; i < 100000; ++i) {
+    auto piece = std::to_string(i);
+    accumulated = accumulated + StringHolder{piece};
+    expected += piece;
+  }
+  REQUIRE(accumulated.get_string() == expected);
+  REQUIRE(accumulated.substr(1000, 50).get_string() == expected.substr(1000, 50));
+  REQUIRE(accumulated.substr(expected.size() + 5).size() == 0);
+}
+TEST_CASE("StringHolder views stay valid when a shared rope is flattened.") {
+  auto left = std::string(200, 'a');
+  auto right = std::string(200, 'b');
+  auto joined = StringHolder{left} + StringHolder{right};
+  auto prefix = joined.substr(0, 150);
+  auto prefix_view = prefix.get_string();
+  REQUIRE(joined.get_string() == left + right);
+  REQUIRE(prefix_view == left.substr(0, 150));
+}
+TEST_CASE("StringHolder keeps joining correctly after parts of it are flattened.") {
+  StringHolder accumulated{""};
+  std::string expected;
+  for(std::size_t i = 0; i < 20000; ++i) {
+    auto piece = std::string(150, (char)('a' + i % 26));
+    accumulated = accumulated + StringHolder{piece};
+    expected += piece;
+    if(i % 97 == 0) {
+      REQUIRE(accumulated.get_string() == expected);
+      auto middle = expected.size() / 3;
+      REQUIRE(accumulated.substr(middle, 1000).get_string() == expected.substr(middle, 1000));
+    }
+  }
+  REQUIRE((accumulated + accumulated).get_string() == expected + expected);
+}
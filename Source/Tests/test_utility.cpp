@@ -1,9 +1,11 @@
 #include "test_utility.hpp"
+#include <bitset>
 
 expression::interactive::Environment setup_enviroment() {
   expression::interactive::Environment environment;
   auto const& u64 = environment.u64();
   auto const& str = environment.str();
+  auto const& big = environment.big();
   static bool init_vec = false;
   static auto vec = expression::data::Vector{environment.axiom_check("Vector", "Type -> Type").head};
   //very ugly hack here... need to find somewhere to store vec with lifetime of environment
@@ -14,7 +16,7 @@ expression::interactive::Environment setup_enviroment() {
   } else {
     init_vec = true;
   }
-  expression::data::builder::RuleMaker rule_maker{environment.context(), u64, str}; //needs to live as long as the rules it creates... meh
+  expression::data::builder::RuleMaker rule_maker{environment.context(), u64, str, big}; //needs to live as long as the rules it creates... meh
 
   {
     using namespace expression::data::builder;
@@ -57,18 +59,66 @@ expression::interactive::Environment setup_enviroment() {
     });
     add_lambda_rule("exp", [](std::uint64_t x, std::uint64_t y) {
       std::uint64_t ret = 1;
-      for(std::uint64_t ct = 0; ct < y; ++ct)
-        ret *= x;
+      for(; y; y >>= 1, x *= x) //by squaring; still wraps modulo 2^64
+        if(y & 1) ret *= x;
       return ret;
     });
+    add_lambda_rule("big_of_u64", [](std::uint64_t x) {
+      return imported_type::BigInt{x};
+    });
+    add_lambda_rule("big_add", [](imported_type::BigInt const& x, imported_type::BigInt const& y) {
+      return x + y;
+    });
+    add_lambda_rule("big_sub", [](imported_type::BigInt const& x, imported_type::BigInt const& y) {
+      return x - y;
+    });
+    add_lambda_rule("big_mul", [](imported_type::BigInt const& x, imported_type::BigInt const& y) {
+      return x * y;
+    });
+    add_lambda_rule("big_div", [](imported_type::BigInt const& x, imported_type::BigInt const& y) { //truncating; x / 0 = 0
+      return divmod(x, y).first;
+    });
+    add_lambda_rule("big_mod", [](imported_type::BigInt const& x, imported_type::BigInt const& y) { //sign of x; x % 0 = x
+      return divmod(x, y).second;
+    });
+    add_lambda_rule("big_pow", [](imported_type::BigInt const& x, std::uint64_t y) {
+      return pow(x, y);
+    });
+    add_lambda_rule("big_to_string", [](imported_type::BigInt const& x) {
+      return imported_type::StringHolder{x.to_string()};
+    });
     add_lambda_rule("len", [](imported_type::StringHolder const& str) {
       return (std::uint64_t)str.size();
     });
     add_lambda_rule("substr", [](imported_type::StringHolder str, std::uint64_t start, std::uint64_t len) {
       return str.substr(start, len);
     });
-    add_lambda_rule("cat", [](imported_type::StringHolder lhs, imported_type::StringHolder rhs) {
-      return imported_type::StringHolder{std::string{lhs.get_string()} + std::string{rhs.get_string()}};
+    add_lambda_rule("cat", [](imported_type::StringHolder const& lhs, imported_type::StringHolder const& rhs) {
+      return lhs + rhs;
+    });
+    add_lambda_rule("char_at", [](imported_type::StringHolder const& str, std::uint64_t index) { //0 past the end, like a terminator
+      auto chars = str.get_string();
+      return index < chars.size() ? (std::uint64_t)(unsigned char)chars[index] : (std::uint64_t)0;
+    });
+    add_lambda_rule("index_of", [](imported_type::StringHolder const& needle, imported_type::StringHolder const& str) { //len str if absent
+      auto position = str.get_string().find(needle.get_string());
+      return position == std::string_view::npos ? (std::uint64_t)str.size() : (std::uint64_t)position;
+    });
+    add_lambda_rule("span_while", [](imported_type::StringHolder const& allowed, imported_type::StringHolder const& str) { //length of the longest prefix of str made of characters in allowed
+      std::bitset<256> table;
+      for(unsigned char c : allowed.get_string()) table.set(c);
+      auto chars = str.get_string();
+      std::size_t length = 0;
+      while(length < chars.size() && table[(unsigned char)chars[length]]) ++length;
+      return (std::uint64_t)length;
+    });
+    add_lambda_rule("parse_u64_prefix", [](imported_type::StringHolder const& str) { //value of the leading decimal digits; wraps like add and mul
+      std::uint64_t value = 0;
+      for(char c : str.get_string()) {
+        if(c < '0' || c > '9') break;
+        value = value * 10 + (std::uint64_t)(c - '0');
+      }
+      return value;
     });
 
     auto starts_with = environment.declare_check("starts_with", "String -> String -> Bool").head;
@@ -99,6 +149,25 @@ expression::interactive::Environment setup_enviroment() {
       }
     );
 
+    auto big_eq = environment.declare_check("big_eq", "BigInt -> BigInt -> Bool").head;
+    auto big_lte = environment.declare_check("big_lte", "BigInt -> BigInt -> Bool").head;
+    auto big_lt = environment.declare_check("big_lt", "BigInt -> BigInt -> Bool").head;
+    environment.context().add_data_rule(
+      pattern(fixed(big_eq), match(big), match(big)) >> [&, yes, no](imported_type::BigInt const& x, imported_type::BigInt const& y) {
+        return tree::Expression{tree::External{ (x == y) ? yes : no }};
+      }
+    );
+    environment.context().add_data_rule(
+      pattern(fixed(big_lte), match(big), match(big)) >> [&, yes, no](imported_type::BigInt const& x, imported_type::BigInt const& y) {
+        return tree::Expression{tree::External{ (x <= y) ? yes : no }};
+      }
+    );
+    environment.context().add_data_rule(
+      pattern(fixed(big_lt), match(big), match(big)) >> [&, yes, no](imported_type::BigInt const& x, imported_type::BigInt const& y) {
+        return tree::Expression{tree::External{ (x < y) ? yes : no }};
+      }
+    );
+
     environment.context().add_data_rule(
       pattern(fixed(iterate), ignore, wildcard, wildcard, match(u64)) >> [&](Expression step, Expression base, std::uint64_t count) {
         for(std::uint64_t i = 0; i < count; ++i) {
@@ -110,6 +179,20 @@ expression::interactive::Environment setup_enviroment() {
         return std::move(base);
       }
     );
+    auto iterate_strict = environment.declare_check("iterate_strict", "(T : Type) -> (T -> T) -> T -> U64 -> T").head;
+    environment.context().add_data_rule(
+      pattern(fixed(iterate_strict), ignore, wildcard, wildcard, match(u64)) >> [&](expression::Context& context, Expression step, Expression base, std::uint64_t count) {
+        //reduces as it goes, rather than building the whole application first
+        base = context.reduce(std::move(base));
+        for(std::uint64_t i = 0; i < count; ++i) {
+          base = context.reduce(expression::multi_apply(
+            step,
+            std::move(base)
+          ));
+        }
+        return std::move(base);
+      }
+    );
     auto empty_vec = environment.declare_check("empty_vec", "(T : Type) -> Vector T").head;
     environment.context().add_data_rule(
       pattern(fixed(empty_vec), wildcard) >> [&](tree::Expression type) {
@@ -118,33 +201,31 @@ expression::interactive::Environment setup_enviroment() {
     );
     auto push_vec = environment.declare_check("push_vec", "(T : Type) -> Vector T -> T -> Vector T").head;
     environment.context().add_data_rule(
-      pattern(fixed(push_vec), wildcard, match(vec), wildcard) >> [&](tree::Expression type, std::vector<tree::Expression> data, tree::Expression then) {
-        data.push_back(then);
-        return vec(std::move(type), std::move(data));
+      pattern(fixed(push_vec), ignore, match(vec), wildcard) >> [&](expression::data::Vector::View const& data, tree::Expression then) {
+        return vec.push(data, std::move(then));
       }
     );
     /*
-    These lines are very odd! Must be factored out later!
+    This line is very odd! Must be factored out later!
     Programmer be warned!
     */
-    environment.context().primitives.empty_vec = empty_vec;
-    environment.context().primitives.push_vec = push_vec;
+    environment.context().primitives.vector = &vec;
 
     auto len_vec = environment.declare_check("len_vec", "(T : Type) -> Vector T -> U64").head;
     environment.context().add_data_rule(
-      pattern(fixed(len_vec), ignore, match(vec)) >> [&](std::vector<tree::Expression> const& data) {
+      pattern(fixed(len_vec), ignore, match(vec)) >> [&](expression::data::Vector::View const& data) {
         return u64(data.size());
       }
     );
     auto at_vec = environment.declare_check("at_vec", "(T : Type) -> (v : Vector T) -> (n : U64) -> Assert (lt n (len_vec T v)) -> T").head;
     environment.context().add_data_rule(
-      pattern(fixed(at_vec), ignore, match(vec), match(u64), fixed(witness)) >> [&](std::vector<tree::Expression> const& data, std::uint64_t index) {
+      pattern(fixed(at_vec), ignore, match(vec), match(u64), fixed(witness)) >> [&](expression::data::Vector::View const& data, std::uint64_t index) {
         return data[index];
       }
     );
     auto recurse_vec = environment.declare_check("lfold_vec", "(S : Type) -> (T : Type) -> S -> (S -> T -> S) -> Vector T -> S").head;
     environment.context().add_data_rule(
-      pattern(fixed(recurse_vec), ignore, ignore, wildcard, wildcard, match(vec)) >> [&](tree::Expression base, tree::Expression op, std::vector<tree::Expression> const& data) {
+      pattern(fixed(recurse_vec), ignore, ignore, wildcard, wildcard, match(vec)) >> [&](tree::Expression base, tree::Expression op, expression::data::Vector::View const& data) {
         for(auto const& expr : data) {
           base = expression::multi_apply(
             op,
@@ -155,6 +236,32 @@ expression::interactive::Environment setup_enviroment() {
         return std::move(base);
       }
     );
+    auto recurse_vec_strict = environment.declare_check("lfold_vec_strict", "(S : Type) -> (T : Type) -> S -> (S -> T -> S) -> Vector T -> S").head;
+    environment.context().add_data_rule(
+      pattern(fixed(recurse_vec_strict), ignore, ignore, wildcard, wildcard, match(vec)) >> [&](expression::Context& context, tree::Expression base, tree::Expression op, expression::data::Vector::View const& data) {
+        base = context.reduce(std::move(base));
+        for(auto const& expr : data) {
+          base = context.reduce(expression::multi_apply(
+            op,
+            std::move(base),
+            expr
+          ));
+        }
+        return std::move(base);
+      }
+    );
   }
+  environment.compact();
   return environment;
 }
+std::string nat_double_block(std::string_view body) {
+  return R"#--#(
+block {
+  axiom Nat : Type;
+  axiom zero : Nat;
+  axiom succ : Nat -> Nat;
+  declare double : Nat -> Nat;
+  double zero = zero;
+  double (succ n) = succ (succ (double n));
+  )#--#" + std::string{body} + "\n}\n";
+}
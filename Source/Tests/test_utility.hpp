@@ -2,7 +2,14 @@
 #define TEST_UTILITY_HPP
 
 #include "../Expression/interactive_environment.hpp"
+#include <string>
+#include <string_view>
 
 expression::interactive::Environment setup_enviroment();
+/*
+  A block declaring Nat, zero, succ and double : Nat -> Nat, followed by body.
+  The rule for double (succ n) is on line 8.
+*/
+std::string nat_double_block(std::string_view body);
 
 #endif
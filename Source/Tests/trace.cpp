@@ -0,0 +1,46 @@
+#include <catch.hpp>
+#include <sstream>
+#include "test_utility.hpp"
+
+TEST_CASE("A tracer records compile phases and solver steps as Chrome trace events.") {
+  mdb::Tracer tracer;
+  auto environment = setup_enviroment();
+  environment.context().tracer = &tracer;
+  std::stringstream output;
+  environment.debug_parse(nat_double_block("double (succ zero)"), output);
+  INFO(output.str());
+  REQUIRE(tracer.event_count() > 0);
+  std::stringstream json;
+  tracer.write(json);
+  auto str = json.str();
+  REQUIRE(str.starts_with("{\"traceEvents\":["));
+  REQUIRE(str.find("\"name\":\"solve\"") != std::string::npos);
+  REQUIRE(str.find("\"name\":\"examine_equation\"") != std::string::npos);
+  REQUIRE(str.find("\"name\":\"rule: add\"") != std::string::npos);
+  REQUIRE(str.find("rule_equation #") != std::string::npos);
+  REQUIRE(str.find(" at line 8\"") != std::string::npos); //the rule for double (succ n)
+}
+TEST_CASE("Nothing is traced without a tracer.") {
+  auto environment = setup_enviroment();
+  REQUIRE(environment.context().tracer == nullptr);
+  mdb::Tracer::Span span{environment.context().tracer, "unused", "test"};
+  REQUIRE(!span);
+}
+TEST_CASE("A tracer streams its events as an open JSON array and forgets them.") {
+  mdb::Tracer tracer;
+  { mdb::Tracer::Span span{&tracer, "first", "test"}; }
+  std::stringstream json;
+  tracer.stream(json);
+  REQUIRE(tracer.event_count() == 0);
+  { mdb::Tracer::Span span{&tracer, "second", "test"}; }
+  tracer.stream(json);
+  REQUIRE(tracer.event_count() == 0);
+  auto str = json.str();
+  REQUIRE(str.starts_with("[\n{\"name\":\"first\""));
+  REQUIRE(str.find(",\n{\"name\":\"second\"") != std::string::npos);
+  auto ts = str.find("\"ts\":");
+  REQUIRE(ts != std::string::npos);
+  auto dot = str.find('.', ts);
+  REQUIRE(str.find_first_not_of("0123456789", ts + 5) == dot); //fixed point, never an exponent
+  REQUIRE(str.find_first_not_of("0123456789", dot + 1) == dot + 4);
+}
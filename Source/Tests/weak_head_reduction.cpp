@@ -0,0 +1,55 @@
+#include <catch.hpp>
+#include <sstream>
+#include "test_utility.hpp"
+#include "../Expression/data_helper.hpp"
+
+TEST_CASE("Weak head reduction stops at an axiom and agrees with full reduction.") {
+  auto environment = setup_enviroment();
+  std::stringstream output;
+  environment.debug_parse(nat_double_block("zero"), output);
+  INFO(output.str());
+  auto expr = environment.parse("double (double (succ zero))");
+  auto succ = environment.parse("succ");
+  REQUIRE(expr.is_fully_solved());
+  REQUIRE(succ.is_fully_solved());
+  auto& context = environment.context();
+  auto whnf = context.reduce_whnf(expr.get_result().value);
+  REQUIRE(expression::spine_head(whnf) == succ.get_result().value);
+  REQUIRE(whnf != expr.get_reduced_result().value);
+  REQUIRE(context.reduce(whnf) == expr.get_reduced_result().value);
+}
+TEST_CASE("Weak head reduction leaves arguments which no rule inspects unreduced.") {
+  auto environment = setup_enviroment();
+  std::stringstream output;
+  environment.debug_parse(nat_double_block(R"#--#(
+  declare pick : Nat -> Nat -> Nat;
+  pick zero y = y;
+  pick (succ n) y = succ y;
+  zero
+)#--#"), output);
+  INFO(output.str());
+  auto expr = environment.parse("pick (double (succ zero)) (double (succ zero))");
+  auto expected = environment.parse("succ (double (succ zero))");
+  REQUIRE(expr.is_fully_solved());
+  REQUIRE(expected.is_fully_solved());
+  auto& context = environment.context();
+  REQUIRE(context.reduce_whnf(expr.get_result().value) == expected.get_result().value);
+}
+TEST_CASE("Elements pushed in place onto a reduced vector are reduced later.") {
+  auto environment = setup_enviroment();
+  auto vec = environment.parse("[add 1 1]");
+  auto element = environment.parse("add 1 2");
+  auto expected = environment.parse("3");
+  REQUIRE(vec.is_fully_solved());
+  REQUIRE(element.is_fully_solved());
+  auto& context = environment.context();
+  auto reduced_vec = vec.get_reduced_result().value; //its children are marked as reduced
+  auto const& data = reduced_vec.get_data().data;
+  auto pushed = context.primitives.vector->push(expression::data::Vector::View{(expression::data::Vector::Store const&)data.storage}, element.get_result().value);
+  std::vector<expression::tree::Expression> children;
+  context.reduce(pushed).get_data().data.visit_children([&](expression::tree::Expression const& child) {
+    children.push_back(child);
+  });
+  REQUIRE(children.size() == 3); //the type and two elements
+  REQUIRE(children[2] == expected.get_reduced_result().value);
+}
@@ -0,0 +1,59 @@
+#ifndef MDB_NODE_POOL_HPP
+#define MDB_NODE_POOL_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace mdb {
+  /*
+    An allocator for small, short-lived objects such as tree nodes. Blocks
+    are carved from large slabs in a few size classes, and freed blocks go on
+    a free list for their class to be handed out again. Slabs are never
+    returned to the system. Not synchronized.
+  */
+  class NodePool {
+    static constexpr std::size_t granularity = 16;
+    static constexpr std::size_t class_count = 8; //blocks of 16, 32, ..., 128 bytes
+    static constexpr std::size_t slab_size = 1 << 16;
+    struct FreeBlock {
+      FreeBlock* next;
+    };
+    std::array<FreeBlock*, class_count> free_lists{};
+    char* slab_position = nullptr;
+    char* slab_end = nullptr;
+    static std::size_t class_of(std::size_t size) { return (size - 1) / granularity; }
+  public:
+    std::uint64_t allocation_count = 0; //blocks handed out so far, for bounding work
+    constexpr NodePool() = default;
+    void* allocate(std::size_t size) {
+      ++allocation_count;
+      if(size > class_count * granularity) return ::operator new(size);
+      auto size_class = class_of(size);
+      if(auto* block = free_lists[size_class]) {
+        free_lists[size_class] = block->next;
+        return block;
+      }
+      auto block_size = (size_class + 1) * granularity;
+      if(std::size_t(slab_end - slab_position) < block_size) {
+        slab_position = (char*)::operator new(slab_size); //the remainder of the old slab is abandoned
+        slab_end = slab_position + slab_size;
+      }
+      auto* ret = slab_position;
+      slab_position += block_size;
+      return ret;
+    }
+    void deallocate(void* ptr, std::size_t size) {
+      if(size > class_count * granularity) {
+        ::operator delete(ptr);
+        return;
+      }
+      auto size_class = class_of(size);
+      free_lists[size_class] = new (ptr) FreeBlock{free_lists[size_class]};
+    }
+  };
+  inline constinit NodePool node_pool; //trivially destructible, so usable by static objects at any time
+}
+
+#endif
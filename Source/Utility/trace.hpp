@@ -0,0 +1,137 @@
+#ifndef MDB_TRACE_HPP
+#define MDB_TRACE_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace mdb {
+  /*
+    Collects timed spans and writes them in the Chrome trace-event format,
+    readable by chrome://tracing and Perfetto. Spans are recorded when they
+    end, so nested spans appear before their parents. Not synchronized.
+  */
+  class Tracer {
+  public:
+    using Clock = std::chrono::steady_clock;
+    struct Event {
+      std::string name;
+      char const* category;
+      Clock::time_point start;
+      Clock::duration duration;
+      std::vector<std::pair<char const*, std::string> > args;
+    };
+    /*
+      Records an event when destroyed. A span made with a null tracer does
+      nothing, and costs little; check it before building arguments.
+    */
+    class Span {
+      Tracer* tracer;
+      Event event;
+    public:
+      Span(Tracer* tracer, std::string_view name, char const* category):tracer(tracer) {
+        if(tracer) {
+          event.name = name;
+          event.category = category;
+          event.start = Clock::now();
+        }
+      }
+      Span(Span const&) = delete;
+      Span& operator=(Span const&) = delete;
+      ~Span() {
+        if(tracer) {
+          event.duration = Clock::now() - event.start;
+          tracer->events.push_back(std::move(event));
+        }
+      }
+      explicit operator bool() const { return tracer; }
+      void arg(char const* key, std::string value) {
+        if(tracer) event.args.emplace_back(key, std::move(value));
+      }
+      void arg(char const* key, std::uint64_t value) {
+        arg(key, std::to_string(value));
+      }
+    };
+    void record(Event event) {
+      events.push_back(std::move(event));
+    }
+    std::size_t event_count() const { return events.size(); }
+    void write(std::ostream& output) const {
+      output << "{\"traceEvents\":[";
+      bool first = true;
+      for(auto const& event : events) {
+        if(!first) output << ",";
+        first = false;
+        write_event(output, event);
+      }
+      output << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    }
+    /*
+      Appends the events recorded since the last call to a JSON array, opening
+      it on the first call, and forgets them - so a long session can stream
+      its trace instead of rewriting it. Chrome and Perfetto accept the array
+      without its closing bracket.
+    */
+    void stream(std::ostream& output) {
+      for(auto const& event : events) {
+        output << (streamed ? "," : "[");
+        streamed = true;
+        write_event(output, event);
+      }
+      events.clear();
+    }
+  private:
+    Clock::time_point origin = Clock::now();
+    std::vector<Event> events;
+    bool streamed = false;
+    void write_event(std::ostream& output, Event const& event) const {
+      output << "\n{\"name\":";
+      write_string(output, event.name);
+      output << ",\"cat\":";
+      write_string(output, event.category);
+      output << ",\"ph\":\"X\",\"pid\":1,\"tid\":1";
+      output << ",\"ts\":";
+      write_microseconds(output, event.start - origin);
+      output << ",\"dur\":";
+      write_microseconds(output, event.duration);
+      if(!event.args.empty()) {
+        output << ",\"args\":{";
+        for(std::size_t i = 0; i < event.args.size(); ++i) {
+          if(i > 0) output << ",";
+          write_string(output, event.args[i].first);
+          output << ":";
+          write_string(output, event.args[i].second);
+        }
+        output << "}";
+      }
+      output << "}";
+    }
+    static void write_microseconds(std::ostream& output, Clock::duration duration) { //exactly, to the nanosecond; floating point output would round late timestamps
+      auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+      auto fraction = std::to_string(nanoseconds % 1000);
+      output << nanoseconds / 1000 << "." << std::string(3 - fraction.size(), '0') << fraction;
+    }
+    static void write_string(std::ostream& output, std::string_view str) {
+      static constexpr char hex[] = "0123456789abcdef";
+      output << '"';
+      for(char c : str) {
+        if(c == '"' || c == '\\') {
+          output << '\\' << c;
+        } else if(c == '\n') {
+          output << "\\n";
+        } else if((unsigned char)c < 0x20) {
+          output << "\\u00" << hex[c >> 4] << hex[c & 15];
+        } else {
+          output << c;
+        }
+      }
+      output << '"';
+    }
+  };
+}
+
+#endif
@@ -16,6 +16,12 @@ jinja_env.filters["camelize"] = inflection.camelize
 jinja_env.filters["underscore"] = inflection.underscore
 jinja_env.tests["empty"] = lambda t: len(t) == 0
 jinja_env.tests["nonempty"] = lambda t: len(t) > 0
+# Member types which interned trees may hash and compare by value.
+internable_types = {"bool", "char", "int", "unsigned", "std::size_t", "std::uint8_t", "std::uint16_t", "std::uint32_t", "std::uint64_t", "std::int8_t", "std::int16_t", "std::int32_t", "std::int64_t"}
+jinja_env.tests["internable"] = lambda member: member["type"] in internable_types
+# Components which trees with inline leaves may store in the handle: a single unsigned member and no children.
+inlinable_types = {"unsigned", "std::size_t", "std::uint8_t", "std::uint16_t", "std::uint32_t", "std::uint64_t"}
+jinja_env.tests["inlinable"] = lambda component: len(component["base_members"]) == 0 and len(component["extra_members"]) == 1 and component["extra_members"][0]["type"] in inlinable_types
 
 def passthrough_call(*, caller):
     return caller()
@@ -384,7 +390,7 @@ class Multitree:
         self.multikind = len(self.kinds) > 1
 
 class TreeOutput:
-    def __init__(self, *, trees, archive_namespace = None, multitrees = None, shared = False):
+    def __init__(self, *, trees, archive_namespace = None, multitrees = None, shared = False, interned = False, inline_leaves = False, atomic_reference_counts = True, node_pool = False):
         self.trees = trees
         self.shape = self.trees[0].shape
         for tree in self.trees:
@@ -400,6 +406,30 @@ class TreeOutput:
             self.archive = None
         self.multitrees = multitrees
         self.shared = shared
+        self.interned = interned
+        if interned:
+            if not shared:
+                raise RuntimeError("Only shared trees can be interned!")
+            for tree in self.trees:
+                for component in tree.components:
+                    for member in component["base_members"]:
+                        if member["type_info"].wrapper_type() != "simple":
+                            raise RuntimeError("Interned trees do not support optional or vector children!")
+        self.inline_leaves = inline_leaves
+        # Shared trees count references atomically unless told they stay on one thread,
+        # and may take their nodes from mdb::node_pool instead of the global allocator.
+        self.shared_options = {
+            "atomic_reference_counts": atomic_reference_counts,
+            "node_pool": node_pool
+        }
+        if (not atomic_reference_counts or node_pool) and not shared:
+            raise RuntimeError("Only shared trees have reference counts or node allocation options!")
+        if inline_leaves:
+            if not interned:
+                raise RuntimeError("Only interned trees can have inline leaves!")
+            for tree in self.trees:
+                if any(len(kind["components"]) > 8 for kind in tree.kinds):
+                    raise RuntimeError("Trees with inline leaves support at most eight components per kind!")
     def write_string(self, file_info):
         return tree_template.render({
             "trees": self.trees,
@@ -407,6 +437,9 @@ class TreeOutput:
             "shape": self.shape,
             "multitrees": self.multitrees,
             "shared": self.shared,
+            "interned": self.interned,
+            "inline_leaves": self.inline_leaves,
+            "shared_options": self.shared_options,
             "file_info": file_info
         })
 